@@ -10,6 +10,18 @@
 #define KEY3  SON_sendCode(0x01,0x15,12)  // Sony TV Power: addr 0x01, cmd 0x15, 12-bit version
 #define KEY4  SAM_sendCode(0x07,0x02)     // Samsung TV Power: addr: 07, cmd: 02
 #define KEY5  DLY_ms(10)                  // nothing
+#define KEY6  DLY_ms(10)                  // KEY6..KEY8 only with LADDER_ENABLE
+#define KEY7  DLY_ms(10)
+#define KEY8  DLY_ms(10)
+
+// Protocols to include (set "0" to exclude a protocol you don't use from the firmware)
+#define USE_NEC     1                     // NEC and extended NEC protocol
+#define USE_SAM     1                     // Samsung protocol
+#define USE_RC5     1                     // Philips RC-5 protocol
+#define USE_SON     1                     // Sony SIRC protocol
+#define USE_LPF     1                     // LEGO Power Functions protocol
+#define USE_RMM     1                     // Nokia RC-MM protocol
+#define USE_XMP     1                     // Motorola XMP protocol
 
 // Pin definitions for keys (pin numbers must be different, regardless of the port!)
 #define PIN_KEY1    PC2                   // define pin to KEY1 (active low)
@@ -17,6 +29,37 @@
 #define PIN_KEY3    PD5                   // define pin to KEY3 (active low)
 #define PIN_KEY4    PD6                   // define pin to KEY4 (active low)
 #define PIN_KEY5    PC1                   // define pin to KEY5 (active low)
+#define KEY_LATCH   1                     // 1: latch key release by EXTI flag, 0: poll pins
+#define KEY_LEAD    1                     // 1: start header mark on key press, debounce meanwhile
+
+// Resistor-ladder keypad with KEY1..KEY8 on a single ADC pin instead (see src/ladder.h)
+#define LADDER_ENABLE 0                   // 1: read keys from PIN_LADDER by the ADC
+#define PIN_LADDER  PC4                   // define pin to ladder (ADC input, ext. pullup)
+
+// Capacitive touch keys with KEY1..KEY4 on touch pads instead (see src/touch.h)
+#define TOUCH_ENABLE 0                    // 1: read keys from touch pads, scan by AWU
+#define PIN_TOUCH1  PC4                   // define pins to touch pads (ADC inputs,
+#define PIN_TOUCH2  PD2                   // external pullup)
+#define PIN_TOUCH3  PD3
+#define PIN_TOUCH4  PD4
+
+// Pin definition for IR-LED (active low, timer1 on PA2, bit-bang on other pins, see src/ir.h)
+#define PIN_LED     PA2
+// #define PIN_LED2    PA1                   // optional second IR-LED on the same port (bit-bang)
+// #define IR_GEN      IR_GEN_SPI            // generate carrier by SPI1 + DMA on PC6 instead
+
+// Wake-on-IR with a duty-cycled IR receiver (see src/wake.h)
+#define WAKE_ENABLE 0                     // 1: look for IR activity every WAKE_PERIOD ms
+#define PIN_RXPWR   PC3                   // define pin to supply (VS) of IR receiver
+#define PIN_RXOUT   PC0                   // define pin to output of IR receiver (active low)
+#define WAKE_ACTION WAKE_idle(WAKE_IDLE)  // action on IR activity (e.g. capture/repeat)
+
+// Remote-to-remote cloning over IrDA SIR on USART1 (see src/clone.h)
+#define CLONE_ENABLE 0                    // 1: include CLONE_*() functions for key actions
+#define CLONE_REMAP 1                     // USART1 on PD0/PD1, PD1 is SWIO (no programmer!)
+
+// Debug output over SWIO, read by the programmer, e.g. "minichlink -T" (see src/debug.h)
+#define DBG_ENABLE  0                     // 1: write debug messages into the mailbox
 
-// Pin definition for IR-LED (active low, do not change until you reconfigure timer!)
-#define PIN_LED     PA2
\ No newline at end of file
+// Factory test mode: test sequence for an IR test fixture (see src/factory.h)
+#define FACTORY_ENABLE 0                  // 1: send test sequence if KEY1 + KEY5 at power-up
@@ -0,0 +1,187 @@
+// ===================================================================================
+// Two-Instance Simulation of Remote-to-Remote Cloning (Host)
+// ===================================================================================
+//
+// Runs the sender and the receiver of src/clone.c in two processes, connected by a
+// socket pair instead of the IrDA link. Each process drops or corrupts the frames it
+// sends with the given probabilities. After each run the received data is compared
+// with the sent data, and the effective throughput is calculated from the air time:
+// all bytes on the link (including lost frames) at CLONE_BAUD plus every timeout and
+// link turnaround. Timeouts of the receiver overlap with the sender's frames and
+// don't count.
+//
+// Build:  make sim  (or: cc -O2 -DCLONE_HOST -DDBG_HOST -I. -Isrc -Isim
+//                        -o bin/clone_sim sim/clone_sim.c src/clone.c src/debug.c
+//                        sim/debugger.c)
+// Usage:  bin/clone_sim [-n bytes] [-l loss%] [-c corrupt%] [-r runs] [-s seed] [-v]
+//
+// With -v, the debug output of the sender (src/debug.c) is shown on stderr.
+//
+// The exit status is 1 if any run failed or delivered wrong data.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "clone.h"
+#include "debug.h"
+#include "debugger.h"
+
+#define SIM_SCALE         10                  // run timeouts 10 times faster
+
+// Link state of this process
+static int      sim_fd;                       // socket to the other instance
+static double   sim_loss, sim_corrupt;        // probabilities per frame
+static uint8_t  sim_frame[CLONE_BLOCK + 16];  // frame being sent
+static int      sim_len;
+static unsigned long sim_bytes;               // bytes sent, including lost frames
+static unsigned long sim_frames, sim_lost, sim_broken;
+static unsigned long sim_wait;                // time spent in timeouts in ms
+static unsigned long sim_turn;                // time spent in turnarounds in ms
+
+static double sim_random(void) {
+  return (double)rand() / ((double)RAND_MAX + 1);
+}
+
+// ===================================================================================
+// Host Link Backend
+// ===================================================================================
+void CLONE_HOST_begin(void) {
+  sim_len = 0;
+}
+
+void CLONE_HOST_putc(uint8_t data) {
+  if(sim_len < (int)sizeof(sim_frame)) sim_frame[sim_len++] = data;
+}
+
+void CLONE_HOST_end(void) {
+  sim_frames++;
+  sim_bytes += sim_len;
+  if(sim_random() < sim_loss) {               // frame lost
+    sim_lost++;
+    return;
+  }
+  if(sim_random() < sim_corrupt) {            // flip one bit
+    sim_broken++;
+    sim_frame[rand() % sim_len] ^= 1 << (rand() % 8);
+  }
+  if(write(sim_fd, sim_frame, sim_len) != sim_len) sim_lost++;  // other side gone
+}
+
+int CLONE_HOST_getc(uint16_t timeout) {
+  struct pollfd pfd = {sim_fd, POLLIN, 0};
+  uint8_t data;
+  int wait = timeout / SIM_SCALE;
+  DBG_flush();                                // programmer reads debug output meanwhile
+  if(poll(&pfd, 1, wait ? wait : 1) <= 0) {
+    sim_wait += timeout;
+    return -1;
+  }
+  if(read(sim_fd, &data, 1) != 1) return -1;
+  return data;
+}
+
+void CLONE_HOST_turn(void) {
+  sim_turn += CLONE_TURN;
+  DBG_flush();
+}
+
+// ===================================================================================
+// Simulation
+// ===================================================================================
+
+// Result passed from the receiver to the sender
+struct sim_result {
+  uint16_t      size;
+  unsigned long bytes;
+  unsigned long turn;
+  uint8_t       data[CLONE_SIZE];
+};
+
+// Run one transfer, returns 0 on success and adds air time (in ms) and payload
+static int sim_run(uint16_t len, unsigned seed, double* air) {
+  int sv[2], res[2];
+  uint8_t data[CLONE_SIZE];
+  struct sim_result result;
+  uint8_t fail;
+  pid_t pid;
+
+  for(int i=0; i<len; i++) data[i] = seed * 31 + i * 7;
+  if(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) || pipe(res)) return 1;
+  sim_bytes = sim_wait = sim_turn = 0;
+  pid = fork();
+  if(pid < 0) return 1;
+  if(!pid) {                                  // receiver
+    close(sv[0]); close(res[0]);
+    sim_fd = sv[1];
+    srand(seed * 2 + 1);
+    memset(&result, 0, sizeof(result));
+    result.size  = CLONE_receive(result.data, sizeof(result.data));
+    result.bytes = sim_bytes;
+    result.turn  = sim_turn;
+    if(write(res[1], &result, sizeof(result)) != sizeof(result)) exit(2);
+    exit(0);
+  }
+  close(sv[1]); close(res[1]);                // sender
+  sim_fd = sv[0];
+  srand(seed * 2);
+  fail = CLONE_send(data, len);
+  DBG_drain(10);
+  if(read(res[0], &result, sizeof(result)) != sizeof(result)) result.size = 0;
+  waitpid(pid, NULL, 0);
+  close(sv[0]); close(res[0]);
+
+  *air += (double)(sim_bytes + result.bytes) * 10000 / CLONE_BAUD
+        + sim_wait + sim_turn + result.turn;
+  if(fail) return 1;
+  if(result.size != len || memcmp(result.data, data, len)) return 2;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  int opt, runs = 10;
+  unsigned seed = time(NULL);
+  uint16_t len = CLONE_SIZE;
+  int failed = 0, wrong = 0;
+  double air = 0;
+
+  while((opt = getopt(argc, argv, "n:l:c:r:s:v")) != -1) {
+    switch(opt) {
+      case 'n': len         = atoi(optarg);       break;
+      case 'l': sim_loss    = atof(optarg) / 100; break;
+      case 'c': sim_corrupt = atof(optarg) / 100; break;
+      case 'r': runs        = atoi(optarg);       break;
+      case 's': seed        = atoi(optarg);       break;
+      case 'v': DBG_HOST_attached = 1;            break;
+      default:
+        fprintf(stderr, "Usage: %s [-n bytes] [-l loss%%] [-c corrupt%%] [-r runs] [-s seed] [-v]\n", argv[0]);
+        return 2;
+    }
+  }
+  signal(SIGPIPE, SIG_IGN);                   // receiver may quit before the sender
+  if(!len || len > CLONE_SIZE) {
+    fprintf(stderr, "size must be 1..%d bytes\n", CLONE_SIZE);
+    return 2;
+  }
+
+  for(int i=0; i<runs; i++) {
+    switch(sim_run(len, seed + i, &air)) {
+      case 1:  failed++; break;
+      case 2:  wrong++;  break;
+    }
+  }
+
+  printf("block %d bytes, %d bytes, loss %.1f%%, corrupt %.1f%%, seed %u\n",
+         CLONE_BLOCK, len, sim_loss * 100, sim_corrupt * 100, seed);
+  printf("frames: %lu sent, %lu lost, %lu corrupted (sender side)\n",
+         sim_frames, sim_lost, sim_broken);
+  printf("runs: %d, failed: %d, wrong data: %d\n", runs, failed, wrong);
+  printf("air time: %.1f ms per run, throughput: %.0f bytes/s (link: %d bytes/s)\n",
+         air / runs, len * runs * 1000 / air, CLONE_BAUD / 10);
+  return (failed || wrong) ? 1 : 0;
+}
@@ -0,0 +1,24 @@
+// ===================================================================================
+// Programmer Emulation for the Debug Mailbox (Host)
+// ===================================================================================
+
+#include <stdio.h>
+#include "debug.h"
+#include "debugger.h"
+
+int           DBG_HOST_attached;
+unsigned long DBG_HOST_chars;
+
+// Read the mailbox if it is full, print the characters and free it
+void DBG_HOST_poll(void) {
+  uint32_t data0 = DBG_HOST_data0;
+  uint32_t data1 = DBG_HOST_data1;
+  int count = (data0 & 0x0F) - 4;
+  if(!DBG_HOST_attached || !(data0 & 0x80)) return;
+  for(int i=0; i<count && i<7; i++) {
+    fputc(i < 3 ? (int)(data0 >> (8 * (i + 1))) & 0xFF : (int)(data1 >> (8 * (i - 3))) & 0xFF,
+          stderr);
+    DBG_HOST_chars++;
+  }
+  DBG_HOST_data0 = 0;
+}
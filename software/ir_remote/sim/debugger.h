@@ -0,0 +1,18 @@
+// ===================================================================================
+// Programmer Emulation for the Debug Mailbox (Host)
+// ===================================================================================
+//
+// Plays the part of the programmer for src/debug.c in host builds (DBG_HOST): each
+// DBG_flush() of the firmware code lets it read the mailbox like minichlink does and
+// write the characters to stderr. While detached, the mailbox is not read, so the
+// firmware code sees a unit without programmer.
+//
+// Variables:
+// ----------
+// DBG_HOST_attached        1: read the mailbox (default 0: detached)
+// DBG_HOST_chars           number of characters read
+
+#pragma once
+
+extern int           DBG_HOST_attached;
+extern unsigned long DBG_HOST_chars;
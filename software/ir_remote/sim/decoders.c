@@ -0,0 +1,296 @@
+// ===================================================================================
+// IR Protocol Decoders (Host)
+// ===================================================================================
+
+#include <math.h>
+#include "decoders.h"
+
+DEC_edge_t DEC_edges[DEC_MAX];
+int        DEC_count;
+
+// Append edge, merge with previous edge of the same level
+void DEC_record(uint8_t mark, double us) {
+  if(DEC_count && DEC_edges[DEC_count - 1].mark == mark) {
+    DEC_edges[DEC_count - 1].us += us;
+    return;
+  }
+  if(DEC_count == DEC_MAX) return;
+  DEC_edges[DEC_count].mark = mark;
+  DEC_edges[DEC_count].us   = us;
+  DEC_count++;
+}
+
+// Clear recorded edges
+void DEC_clear(void) {
+  DEC_count = 0;
+}
+
+// Check edge i against nominal length, track largest deviation
+static int DEC_match(const DEC_edge_t* e, int n, int i, uint8_t mark, double us,
+                     double* err) {
+  double d;
+  if(i >= n || e[i].mark != mark) return 0;
+  d = fabs(e[i].us - us);
+  if(d > us * DEC_TOL && d > DEC_ABS) return 0;
+  if(d > *err) *err = d;
+  return 1;
+}
+
+// Space i ends the frame (or is missing at the end of the recording)
+static int DEC_end(const DEC_edge_t* e, int n, int i) {
+  return i >= n || (!e[i].mark && e[i].us > DEC_GAP);
+}
+
+// ===================================================================================
+// Nokia RC-MM
+// ===================================================================================
+#define RMM_T             (1000000.0 / 36000) // carrier period in us
+
+int DEC_RMM(const DEC_edge_t* e, int n, uint32_t* data, uint8_t* bits, double* err) {
+  int i = 2;
+  *data = 0; *bits = 0; *err = 0;
+  if(!DEC_match(e, n, 0, 1, 15 * RMM_T, err)) return 0;
+  if(!DEC_match(e, n, 1, 0, 10 * RMM_T, err)) return 0;
+  while(1) {
+    if(!DEC_match(e, n, i++, 1, 6 * RMM_T, err)) return 0;
+    if(DEC_end(e, n, i)) break;               // stop mark
+    if(e[i].mark) return 0;
+    double period = e[i - 1].us + e[i].us;    // mark + space, robust to stretched marks
+    int sym = (int)lround((period / RMM_T - 16) / 6);
+    if(sym < 0 || sym > 3) return 0;
+    double d = fabs(period - (16 + 6 * sym) * RMM_T);
+    if(d > 2 * RMM_T) return 0;
+    if(d > *err) *err = d;
+    i++;
+    if(*bits == 32) return 0;
+    *data = (*data << 2) | sym;
+    *bits += 2;
+  }
+  if(*bits != 12 && *bits != 24 && *bits != 32) return 0;
+  return i < n ? i + 1 : i;
+}
+
+// ===================================================================================
+// Motorola XMP
+// ===================================================================================
+#define XMP_MARK          210.0
+#define XMP_ZERO          760.0
+#define XMP_UNIT          136.0
+
+// Decode packet of 8 nibbles, returns edges consumed or 0
+static int DEC_XMP_packet(const DEC_edge_t* e, int n, uint32_t* value, double* err) {
+  uint8_t sum = 0;
+  int i = 0;
+  *value = 0;
+  for(uint8_t k=0; k<8; k++) {
+    if(!DEC_match(e, n, i++, 1, XMP_MARK, err) || i >= n || e[i].mark) return 0;
+    double period = e[i - 1].us + e[i].us;    // mark + space, robust to stretched marks
+    int nib = (int)lround((period - XMP_MARK - XMP_ZERO) / XMP_UNIT);
+    if(nib < 0 || nib > 15) return 0;
+    double d = fabs(period - (XMP_MARK + XMP_ZERO + nib * XMP_UNIT));
+    if(d > XMP_UNIT / 2) return 0;
+    if(d > *err) *err = d;
+    i++;
+    *value = (*value << 4) | nib;
+    sum += nib;
+  }
+  if(!DEC_match(e, n, i++, 1, XMP_MARK, err)) return 0;
+  if(!DEC_end(e, n, i) || (sum & 0x0f)) return 0;  // checksum
+  return i < n ? i + 1 : i;
+}
+
+int DEC_XMP(const DEC_edge_t* e, int n, uint8_t* oem, uint8_t* dev, uint8_t* sub,
+            uint16_t* func, uint8_t* toggle, double* err) {
+  uint32_t p1, p2;
+  int i, j;
+  *err = 0;
+  if(!(i = DEC_XMP_packet(e, n, &p1, err))) return 0;
+  if(!(j = DEC_XMP_packet(e + i, n - i, &p2, err))) return 0;
+  if(((p1 >> 16) & 0x0f) != 0x0f) return 0;             // fixed nibble
+  if((p1 >> 28) != (p2 >> 28) || ((p1 >> 20) & 0x0f) != ((p2 >> 16) & 0x0f)) return 0;
+  *sub    = (p1 >> 24 & 0xf0) | (p1 >> 20 & 0x0f);
+  *oem    = p1 >> 8;
+  *dev    = p1;
+  *toggle = (p2 >> 20) & 0x0f;
+  *func   = p2;
+  return i + j;
+}
+
+// ===================================================================================
+// Pulse Distance (LSB first)
+// ===================================================================================
+
+// Decode bits of one unit marks and one/three unit spaces after edge i, followed by a
+// stop mark, returns index behind the stop mark or 0
+static int DEC_PD(const DEC_edge_t* e, int n, int i, double unit, uint8_t bits,
+                  uint64_t* value, double* err) {
+  *value = 0;
+  for(uint8_t b=0; b<bits; b++) {
+    if(!DEC_match(e, n, i++, 1, unit, err) || i >= n || e[i].mark) return 0;
+    if(e[i].us > 2 * unit) {
+      if(!DEC_match(e, n, i++, 0, 3 * unit, err)) return 0;
+      *value |= (uint64_t)1 << b;
+    }
+    else if(!DEC_match(e, n, i++, 0, unit, err)) return 0;
+  }
+  if(!DEC_match(e, n, i++, 1, unit, err)) return 0;
+  return i;
+}
+
+// ===================================================================================
+// Samsung36 and Samsung48
+// ===================================================================================
+int DEC_SAM36(const DEC_edge_t* e, int n, uint16_t* addr, uint16_t* cmd, double* err) {
+  uint64_t head, tail;
+  int i;
+  *err = 0;
+  if(!DEC_match(e, n, 0, 1, 4500, err) || !DEC_match(e, n, 1, 0, 4500, err)) return 0;
+  if(!(i = DEC_PD(e, n, 2, 500, 16, &head, err))) return 0;
+  if(!DEC_match(e, n, i++, 0, 4500, err)) return 0;    // mid-frame gap
+  if(!(i = DEC_PD(e, n, i, 500, 20, &tail, err))) return 0;
+  if(((tail >> 4) ^ (tail >> 12) ^ 0xff) & 0xff) return 0;  // F and ~F
+  if(!DEC_end(e, n, i)) return 0;
+  *addr = head;
+  *cmd  = ((tail & 0x0f) << 8) | ((tail >> 4) & 0xff);
+  return i < n ? i + 1 : i;
+}
+
+int DEC_SAM48(const DEC_edge_t* e, int n, uint16_t* addr, uint16_t* cmd, double* err) {
+  uint64_t v;
+  int i;
+  *err = 0;
+  if(!DEC_match(e, n, 0, 1, 4500, err) || !DEC_match(e, n, 1, 0, 4500, err)) return 0;
+  if(!(i = DEC_PD(e, n, 2, 560, 48, &v, err))) return 0;
+  if(((v >> 16) ^ (v >> 24) ^ 0xff) & 0xff) return 0;  // E and ~E
+  if(((v >> 32) ^ (v >> 40) ^ 0xff) & 0xff) return 0;  // F and ~F
+  if(!DEC_end(e, n, i)) return 0;
+  *addr = v;
+  *cmd  = ((v >> 8) & 0xff00) | ((v >> 32) & 0xff);
+  return i < n ? i + 1 : i;
+}
+
+// ===================================================================================
+// NEC and Samsung
+// ===================================================================================
+int DEC_NEC(const DEC_edge_t* e, int n, uint16_t* addr, uint8_t* cmd, uint8_t* repeat,
+            double* err) {
+  uint64_t v;
+  int i;
+  *err = 0; *repeat = 0;
+  if(!DEC_match(e, n, 0, 1, 9000, err)) return 0;
+  if(DEC_match(e, n, 1, 0, 2250, err)) {      // repeat code
+    if(!DEC_match(e, n, 2, 1, 562.5, err) || !DEC_end(e, n, 3)) return 0;
+    *repeat = 1;
+    return 3 < n ? 4 : 3;
+  }
+  if(!DEC_match(e, n, 1, 0, 4500, err)) return 0;
+  if(!(i = DEC_PD(e, n, 2, 562.5, 32, &v, err))) return 0;
+  if(((v >> 16) ^ (v >> 24) ^ 0xff) & 0xff) return 0;  // command and inverse
+  if(!DEC_end(e, n, i)) return 0;
+  *addr = (((v ^ (v >> 8)) & 0xff) == 0xff) ? (v & 0xff) : (v & 0xffff);
+  *cmd  = v >> 16;
+  return i < n ? i + 1 : i;
+}
+
+int DEC_SAM(const DEC_edge_t* e, int n, uint8_t* addr, uint8_t* cmd, double* err) {
+  uint64_t v;
+  int i;
+  *err = 0;
+  if(!DEC_match(e, n, 0, 1, 4500, err) || !DEC_match(e, n, 1, 0, 4500, err)) return 0;
+  if(!(i = DEC_PD(e, n, 2, 562.5, 32, &v, err))) return 0;
+  if((v & 0xff) != ((v >> 8) & 0xff)) return 0;          // address twice
+  if(((v >> 16) ^ (v >> 24) ^ 0xff) & 0xff) return 0;    // command and inverse
+  if(!DEC_end(e, n, i)) return 0;
+  *addr = v;
+  *cmd  = v >> 16;
+  return i < n ? i + 1 : i;
+}
+
+// ===================================================================================
+// RC-5
+// ===================================================================================
+#define RC5_HALF          889.0               // half bit in us
+#define RC5_BITS          14
+
+// The first half of the first start bit is a space, which can't be told from the idle
+// receiver, so the frame starts with the mark of its second half. Each edge is one or
+// two half bits long, the space of a final "0" merges with the pause after the frame.
+int DEC_RC5(const DEC_edge_t* e, int n, uint8_t* addr, uint8_t* cmd, uint8_t* toggle,
+            double* err) {
+  uint8_t  half[2 * RC5_BITS];
+  uint16_t msg = 0;
+  int h = 1, i = 0;
+  *err = 0;
+  half[0] = 0;
+  if(n < 1 || !e[0].mark) return 0;
+  while(h < 2 * RC5_BITS) {
+    if(DEC_end(e, n, i)) {                    // pause: the rest is space
+      while(h < 2 * RC5_BITS) half[h++] = 0;
+      break;
+    }
+    int k = (e[i].us > 1.5 * RC5_HALF) ? 2 : 1;
+    if(!DEC_match(e, n, i, e[i].mark, k * RC5_HALF, err)) return 0;
+    if(h + k > 2 * RC5_BITS) return 0;
+    while(k--) half[h++] = e[i].mark;
+    i++;
+  }
+  if(!DEC_end(e, n, i)) return 0;
+  for(int b=0; b<RC5_BITS; b++) {             // bit value is its second half
+    if(half[2 * b] == half[2 * b + 1]) return 0;
+    msg = (msg << 1) | half[2 * b + 1];
+  }
+  *toggle = (msg >> 11) & 1;
+  *addr   = (msg >> 6) & 0x1f;
+  *cmd    = (msg & 0x3f) | ((msg & 0x1000) ? 0 : 0x40);  // field bit is inverse of bit 6
+  return i < n ? i + 1 : i;
+}
+
+// ===================================================================================
+// Sony SIRC
+// ===================================================================================
+
+// The space of the last bit merges with the pause after the frame
+int DEC_SON(const DEC_edge_t* e, int n, uint16_t* addr, uint8_t* cmd, uint8_t* bits,
+            double* err) {
+  uint32_t v = 0;
+  int i = 2;
+  *err = 0; *bits = 0;
+  if(!DEC_match(e, n, 0, 1, 2400, err) || !DEC_match(e, n, 1, 0, 600, err)) return 0;
+  while(1) {
+    if(*bits == 20) return 0;
+    if(DEC_match(e, n, i, 1, 1200, err)) v |= (uint32_t)1 << *bits;
+    else if(!DEC_match(e, n, i, 1, 600, err)) return 0;
+    i++;
+    (*bits)++;
+    if(DEC_end(e, n, i)) break;
+    if(!DEC_match(e, n, i++, 0, 600, err)) return 0;
+  }
+  if(*bits != 12 && *bits != 15 && *bits != 20) return 0;
+  *cmd  = v & 0x7f;
+  *addr = v >> 7;
+  return i < n ? i + 1 : i;
+}
+
+// ===================================================================================
+// Factory Test Report (see src/factory.h)
+// ===================================================================================
+int DEC_FACTORY(const DEC_edge_t* e, int n, uint8_t* report, uint8_t len, double* err) {
+  int i = 2;
+  uint8_t sum = 0;
+  *err = 0;
+  if(!DEC_match(e, n, 0, 1, 4500, err) || !DEC_match(e, n, 1, 0, 2250, err)) return 0;
+  for(uint8_t k=0; k<len; k++) {
+    report[k] = 0;
+    for(uint8_t b=0; b<8; b++) {
+      if(!DEC_match(e, n, i++, 1, 281.25, err) || i >= n || e[i].mark) return 0;
+      if(e[i].us > 562.5) {
+        if(!DEC_match(e, n, i++, 0, 843.75, err)) return 0;
+        report[k] |= 1 << b;
+      }
+      else if(!DEC_match(e, n, i++, 0, 281.25, err)) return 0;
+    }
+    sum += report[k];
+  }
+  if(!DEC_match(e, n, i++, 1, 281.25, err) || !DEC_end(e, n, i) || sum) return 0;
+  return i < n ? i + 1 : i;
+}
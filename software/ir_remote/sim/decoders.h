@@ -0,0 +1,59 @@
+// ===================================================================================
+// IR Protocol Decoders (Host)
+// ===================================================================================
+//
+// Decode a recorded list of marks and spaces (as seen at the output of an IR
+// receiver) back into the codes of the encoders in src/protocols.c. Each decoder
+// returns the number of edges consumed (0: no valid frame at the start of the list)
+// and the largest deviation of an edge from its nominal length in microseconds.
+//
+// Functions available:
+// --------------------
+// DEC_record(mark, us)                       append edge, merges with previous edge
+// DEC_clear()                                clear recorded edges
+// DEC_NEC(e, n, &addr, &cmd, &repeat, &err)  decode NEC frame or repeat code
+// DEC_SAM(e, n, &addr, &cmd, &err)           decode Samsung frame
+// DEC_RC5(e, n, &addr, &cmd, &toggle, &err)  decode RC-5 frame (7-bit command)
+// DEC_SON(e, n, &addr, &cmd, &bits, &err)    decode Sony SIRC frame (12, 15 or 20 bits)
+// DEC_RMM(e, n, &data, &bits, &err)          decode Nokia RC-MM frame
+// DEC_XMP(e, n, &oem, &dev, &sub, &func, &toggle, &err)  decode Motorola XMP frame
+// DEC_SAM36(e, n, &addr, &cmd, &err)         decode Samsung36 frame
+// DEC_SAM48(e, n, &addr, &cmd, &err)         decode Samsung48 frame
+// DEC_FACTORY(e, n, report, len, &err)       decode factory test report of len bytes
+//
+// A space longer than DEC_GAP ends a frame, the last space of a recording may also
+// be missing.
+
+#pragma once
+
+#include <stdint.h>
+
+#define DEC_MAX           4096                // max number of recorded edges
+#define DEC_GAP           5000                // min space between frames in us
+#define DEC_TOL           0.25                // tolerance relative to the nominal edge
+#define DEC_ABS           100                 // but at least (short edges) in us
+
+// Recorded edge
+typedef struct {
+  uint8_t mark;                               // 1: mark, 0: space
+  double  us;                                 // length in microseconds
+} DEC_edge_t;
+
+extern DEC_edge_t DEC_edges[DEC_MAX];         // recorded edges
+extern int        DEC_count;                  // number of recorded edges
+
+void DEC_record(uint8_t mark, double us);
+void DEC_clear(void);
+int  DEC_NEC(const DEC_edge_t* e, int n, uint16_t* addr, uint8_t* cmd, uint8_t* repeat,
+             double* err);
+int  DEC_SAM(const DEC_edge_t* e, int n, uint8_t* addr, uint8_t* cmd, double* err);
+int  DEC_RC5(const DEC_edge_t* e, int n, uint8_t* addr, uint8_t* cmd, uint8_t* toggle,
+             double* err);
+int  DEC_SON(const DEC_edge_t* e, int n, uint16_t* addr, uint8_t* cmd, uint8_t* bits,
+             double* err);
+int  DEC_RMM(const DEC_edge_t* e, int n, uint32_t* data, uint8_t* bits, double* err);
+int  DEC_XMP(const DEC_edge_t* e, int n, uint8_t* oem, uint8_t* dev, uint8_t* sub,
+             uint16_t* func, uint8_t* toggle, double* err);
+int  DEC_SAM36(const DEC_edge_t* e, int n, uint16_t* addr, uint16_t* cmd, double* err);
+int  DEC_SAM48(const DEC_edge_t* e, int n, uint16_t* addr, uint16_t* cmd, double* err);
+int  DEC_FACTORY(const DEC_edge_t* e, int n, uint8_t* report, uint8_t len, double* err);
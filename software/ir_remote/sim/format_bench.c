@@ -0,0 +1,601 @@
+// ===================================================================================
+// Storage Format Benchmark for IR Codes (Host)
+// ===================================================================================
+//
+// Compares formats for storing IR codes in flash (a code library or learned codes) on
+// a corpus of codes:
+//
+// Format    Content
+// --------  --------------------------------------------------------------------------
+// raw       carrier in kHz, number of edges, each edge in system ticks (2 bytes, or 4
+//           bytes from 32768 ticks on)
+// dict+RLE  carrier, number of entries and nibbles, dictionary of up to 15 durations
+//           (as raw), each edge as a 4-bit index; a run of repeats of the previous
+//           mark/space pair is nibble 15 followed by the number of repeats - 1
+// proto     protocol ID and parameters (address, command, ...), the edges are
+//           generated by the encoders of src/protocols.c
+// Pronto    Pronto hex in binary: 4 header words, each edge as the number of carrier
+//           periods in a 16-bit word, padded to mark/space pairs
+//
+// The corpus is generated by the encoders: -n codes with random parameters for each of
+// the 9 protocols (including the variants of Samsung, SIRC and RC-MM). -x and -j
+// distort the edges like a learned code: marks are extended by -x us (spaces shortened
+// accordingly), each edge is shifted by up to -j us. Codes from files (-f, may be given
+// more than once) are added: one code per line, either Pronto hex ("0000 006D 0022
+// 0002 0155 00AA ...") or raw timings (carrier in Hz, then marks and spaces in us, e.g.
+// "38000 9000 4500 560 560 ..."), lines starting with '#' are skipped. There is no
+// protocol information for these, so they can't be stored by proto.
+//
+// For each format the report lists the number of codes it can store, the bytes per
+// code, the decode cycles per edge on the rv32ec core and the timing error of the
+// decoded edges against the nominal timing of the encoder (for codes from files:
+// against the timing in the file). The error is the quantization of the format plus
+// the part of the distortion that the format keeps. With -v the bytes per code and
+// the error are listed for each protocol as well.
+//
+// Cycle model (QingKe V2A, flash without wait states at 1.5MHz): CYC_ALU, CYC_LOAD and
+// CYC_JUMP of system.h, the figures the delay compensation and the IR_GEN_BITBANG loop
+// of the firmware are calibrated with (1 cycle for an ALU instruction or a branch not
+// taken, 2 for a load, a taken branch or a jump). The decoders below are written as
+// the firmware would do it, each step adds the cycles of the instructions it compiles
+// to. rv32ec has no multiply instruction, Pronto calls __mulsi3 of libgcc (shift and
+// add, one loop per bit of the second operand). For proto the inner loop of the
+// encoder is estimated per protocol family. Handing the edge to IR_markTicks()/
+// IR_spaceTicks() is the same for all formats and not counted.
+// The numbers rank the formats, they don't replace a measurement on the device.
+//
+// Build:  make sim  (or: cc -O2 -DIR_HOST -I. -Isrc -Isim -o bin/format_bench
+//                        sim/format_bench.c src/protocols.c src/ir.c -lm)
+// Usage:  bin/format_bench [-n codes] [-x us] [-j us] [-q tolerance%] [-f file] [-v]
+//                          [-s seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include "protocols.h"
+
+#define FB_EDGES          512                 // max edges per code
+#define FB_BYTES          (4 * FB_EDGES + 64) // max bytes of a stored code
+#define FB_DICT           15                  // max dictionary entries (15: RLE escape)
+#define FB_FILES          8                   // max number of corpus files
+#define FB_PRONTO_UNIT    0.241246            // Pronto frequency unit in us
+#define FB_LEADOUT        10000               // Pronto: space after a code ending in a mark
+
+// Cycle model
+#define CY_ALU            CYC_ALU             // ALU instruction, branch not taken
+#define CY_LOAD           CYC_LOAD            // lbu, lhu, lw
+#define CY_JUMP           CYC_JUMP            // taken branch, jal, ret
+
+// Formats
+enum { FB_RAW, FB_DICT_RLE, FB_PROTO, FB_PRONTO, FB_FORMATS };
+static const char* fb_formats[FB_FORMATS] = {"raw", "dict+RLE", "proto", "Pronto"};
+
+// Groups of the corpus: protocols and files
+enum { FB_NEC, FB_SAM, FB_SAM36, FB_SAM48, FB_RC5, FB_SON, FB_LPF, FB_RMM, FB_XMP,
+       FB_FILE, FB_GROUPS };
+static const char* fb_groups[FB_GROUPS] = {"NEC", "Samsung", "Samsung36", "Samsung48",
+  "RC-5", "SIRC", "LEGO PF", "RC-MM", "XMP", "files"};
+
+// Proto: cycles per edge of the encoder's inner loop (bit test, timing from the
+// descriptor or table, loop), the pulse distance protocols use PD_send()
+static const int fb_protoCycles[FB_GROUPS] = {10, 10, 10, 10, 8, 6, 10, 12, 12, 0};
+#define FB_PROTO_SETUP    20                  // dispatch by ID, load parameters
+
+// Code of the corpus
+typedef struct {
+  int      group;                             // protocol or file
+  uint32_t freq;                              // carrier frequency in Hz
+  int      count;                             // number of edges, mark first
+  uint32_t ref[FB_EDGES];                     // nominal edges in ticks
+  uint32_t edge[FB_EDGES];                    // edges to store (distorted) in ticks
+  int      params;                            // proto: bytes of ID + parameters
+} FB_code_t;
+
+// Statistics of a format
+typedef struct {
+  int    codes, bytesMax, cyclesMax;
+  double bytes, edges, cycles, err, errMax;
+} FB_stat_t;
+
+static FB_code_t fb_code;
+static FB_stat_t fb_stat[FB_GROUPS + 1][FB_FORMATS];  // last row: all groups
+static double    fb_tol = 0.05;               // dictionary tolerance
+static double    fb_extend, fb_jitter;        // distortion in us
+
+// ===================================================================================
+// Host Backends
+// ===================================================================================
+void IR_HOST_carrier(uint32_t freq) {
+  fb_code.freq = freq;
+}
+
+// Record edges, merge edges of the same level, skip leading spaces
+void IR_HOST_edge(uint8_t mark, uint32_t ticks) {
+  int n = fb_code.count;
+  if(!ticks || (!n && !mark)) return;
+  if(n && (n & 1) == mark) fb_code.ref[n - 1] += ticks;
+  else if(n < FB_EDGES)    fb_code.ref[fb_code.count++] = ticks;
+}
+
+uint8_t KEY_read(void) {
+  return 0;                                   // one press, no repeats
+}
+
+// ===================================================================================
+// Cycle Accounting
+// ===================================================================================
+static uint32_t fb_cycles, fb_mark;           // cycles of the code, at the last edge
+static int      fb_worst;                     // most cycles of a single edge
+
+// Edge is ready, note the cycles since the previous edge
+static void fb_edge(uint32_t* out, int* n, uint32_t ticks) {
+  int cy = fb_cycles - fb_mark;
+  if(cy > fb_worst) fb_worst = cy;
+  fb_mark = fb_cycles;
+  if(*n < FB_EDGES + 1) out[(*n)++] = ticks;
+}
+
+// a * b by __mulsi3 of libgcc: mv, li, then per bit of b: andi, beqz, (add), srli,
+// slli, bnez; the call (jal, ret) is counted by the caller
+static uint32_t fb_mul(uint32_t a, uint32_t b) {
+  uint32_t r = a * b;
+  fb_cycles += 2 * CY_ALU;
+  do {
+    fb_cycles += CY_ALU + ((b & 1) ? CY_ALU + CY_ALU : CY_JUMP) + 2 * CY_ALU;
+    b >>= 1;
+    fb_cycles += b ? CY_JUMP : CY_ALU;
+  } while(b);
+  return r;
+}
+
+// ===================================================================================
+// Durations in 2 or 4 Bytes (raw, dictionary)
+// ===================================================================================
+static int fb_putTicks(uint8_t* out, uint32_t ticks) {
+  if(ticks < 0x8000) {
+    out[0] = ticks; out[1] = ticks >> 8;
+    return 2;
+  }
+  out[0] = ticks >> 16; out[1] = 0x80 | ticks >> 24;  // high word first, bit 15 set
+  out[2] = ticks;       out[3] = ticks >> 8;
+  return 4;
+}
+
+static uint32_t fb_getTicks(const uint8_t** p) {
+  uint32_t t = (*p)[0] | (*p)[1] << 8;
+  *p += 2;
+  fb_cycles += CY_LOAD + CY_ALU + CY_ALU + CY_ALU;    // lhu, addi, slli, bltz
+  if(t & 0x8000) {                                   // taken, lhu, addi, slli, srli,
+    t = (t & 0x7FFF) << 16 | (*p)[0] | (*p)[1] << 8; // or, j back
+    *p += 2;
+    fb_cycles += CY_JUMP - CY_ALU + CY_LOAD + 4 * CY_ALU + CY_JUMP;
+  }
+  return t;
+}
+
+// ===================================================================================
+// Raw
+// ===================================================================================
+static int fb_rawStore(const FB_code_t* c, uint8_t* out) {
+  int len = 0;
+  if(c->count > 255) return 0;
+  out[len++] = (c->freq + 500) / 1000;
+  out[len++] = c->count;
+  for(int i=0; i<c->count; i++) len += fb_putTicks(out + len, c->edge[i]);
+  return len;
+}
+
+static int fb_rawLoad(const uint8_t* p, uint32_t* out) {
+  int n = 0, count = p[1];
+  fb_cycles += 2 * CY_LOAD + CY_ALU;                 // lbu carrier, lbu count, addi
+  fb_mark = fb_cycles;
+  p += 2;
+  while(count--) {
+    uint32_t t = fb_getTicks(&p);
+    fb_cycles += CY_ALU + CY_JUMP;                   // addi, bnez
+    fb_edge(out, &n, t);
+  }
+  return n;
+}
+
+// ===================================================================================
+// Dictionary + RLE
+// ===================================================================================
+
+// Cluster the durations of the code into at most FB_DICT entries: sorted durations
+// within the tolerance of the shortest one of a cluster share an entry, then the two
+// neighbouring clusters with the smallest gap are merged until the dictionary fits.
+// The entry is the mean of its durations.
+static int fb_cluster(const FB_code_t* c, uint32_t* dict, uint8_t* index) {
+  uint32_t v[FB_EDGES], lo[FB_EDGES], hi[FB_EDGES];
+  double   sum[FB_EDGES];
+  int      cnt[FB_EDGES], m = 0;
+  memcpy(v, c->edge, c->count * sizeof(uint32_t));
+  for(int i=1; i<c->count; i++) {                    // insertion sort
+    uint32_t x = v[i];
+    int j = i;
+    while(j && v[j - 1] > x) { v[j] = v[j - 1]; j--; }
+    v[j] = x;
+  }
+  for(int i=0; i<c->count; i++) {
+    if(!m || v[i] > lo[m - 1] * (1 + fb_tol)) {
+      lo[m] = v[i]; sum[m] = 0; cnt[m] = 0; m++;
+    }
+    hi[m - 1] = v[i]; sum[m - 1] += v[i]; cnt[m - 1]++;
+  }
+  while(m > FB_DICT) {
+    int best = 0;
+    for(int j=1; j<m-1; j++) {
+      if((double)lo[j + 1] / hi[j] < (double)lo[best + 1] / hi[best]) best = j;
+    }
+    hi[best] = hi[best + 1]; sum[best] += sum[best + 1]; cnt[best] += cnt[best + 1];
+    m--;
+    for(int j=best+1; j<m; j++) {
+      lo[j] = lo[j + 1]; hi[j] = hi[j + 1]; sum[j] = sum[j + 1]; cnt[j] = cnt[j + 1];
+    }
+  }
+  for(int j=0; j<m; j++) dict[j] = sum[j] / cnt[j] + 0.5;
+  for(int i=0; i<c->count; i++) {
+    int j = 0;
+    while(c->edge[i] > hi[j]) j++;
+    index[i] = j;
+  }
+  return m;
+}
+
+static int fb_dictStore(const FB_code_t* c, uint8_t* out) {
+  uint32_t dict[FB_DICT];
+  uint8_t  index[FB_EDGES], nibble[2 * FB_EDGES];
+  int      entries = fb_cluster(c, dict, index), nibbles = 0, len = 3;
+
+  for(int i=0; i<c->count; ) {
+    int run = 0;                                     // repeats of the previous pair
+    if(i >= 2 && !(i & 1)) {
+      while(run < 16 && i + 2 * run + 1 < c->count
+            && index[i + 2 * run] == index[i - 2] && index[i + 2 * run + 1] == index[i - 1])
+        run++;
+    }
+    if(run >= 2) {                                   // escape pays off from 2 pairs on
+      nibble[nibbles++] = 15;
+      nibble[nibbles++] = run - 1;
+      i += 2 * run;
+    }
+    else nibble[nibbles++] = index[i++];
+  }
+  if(nibbles > 255) return 0;
+  out[0] = (c->freq + 500) / 1000;
+  out[1] = entries;
+  out[2] = nibbles;
+  for(int j=0; j<entries; j++) len += fb_putTicks(out + len, dict[j]);
+  for(int i=0; i<nibbles; i+=2) {
+    out[len++] = nibble[i] | ((i + 1 < nibbles) ? nibble[i + 1] << 4 : 0);
+  }
+  return len;
+}
+
+// Next nibble, the current byte is held in a register: even: andi, beqz (not taken),
+// lbu, addi, andi, j; odd: andi, bnez (taken), srli
+static uint8_t fb_nibble(const uint8_t* p, int i) {
+  if(i & 1) {
+    fb_cycles += CY_ALU + CY_JUMP + CY_ALU;
+    return p[i >> 1] >> 4;
+  }
+  fb_cycles += CY_ALU + CY_ALU + CY_LOAD + CY_ALU + CY_ALU + CY_JUMP;
+  return p[i >> 1] & 0x0F;
+}
+
+static int fb_dictLoad(const uint8_t* p, uint32_t* out) {
+  uint32_t dict[FB_DICT], prev[2] = {0, 0};
+  int      n = 0, entries = p[1], nibbles = p[2];
+  fb_cycles += 3 * CY_LOAD + CY_ALU;                 // lbu header, addi
+  p += 3;
+  for(int j=0; j<entries; j++) {                     // expand dictionary into RAM
+    dict[j] = fb_getTicks(&p);
+    fb_cycles += CY_ALU + CY_ALU + CY_ALU + CY_JUMP; // sw, addi, addi, bne
+  }
+  fb_mark = fb_cycles;
+  for(int i=0; i<nibbles; ) {
+    uint8_t x = fb_nibble(p, i++);
+    fb_cycles += CY_ALU + CY_ALU;                    // li, beq (not taken)
+    if(x == 15) {                                    // RLE: repeat previous pair
+      int run = fb_nibble(p, i++) + 1;
+      fb_cycles += CY_JUMP - CY_ALU + CY_ALU;        // taken, addi
+      while(run--) {
+        fb_edge(out, &n, prev[0]);
+        fb_cycles += CY_ALU + CY_JUMP;               // addi, bnez
+        fb_edge(out, &n, prev[1]);
+      }
+      fb_cycles += CY_JUMP;                          // j loop
+      continue;
+    }
+    uint32_t t = dict[x];
+    fb_cycles += 2 * CY_ALU + CY_LOAD + 2 * CY_ALU;  // slli, add, lw, mv prev pair
+    fb_cycles += CY_ALU + CY_JUMP;                   // compare, blt loop
+    prev[0] = prev[1]; prev[1] = t;
+    fb_edge(out, &n, t);
+  }
+  return n;
+}
+
+// ===================================================================================
+// Pronto
+// ===================================================================================
+static int fb_prontoStore(const FB_code_t* c, uint8_t* out) {
+  uint16_t word = 1000000.0 / (c->freq * FB_PRONTO_UNIT) + 0.5;
+  double   period = word * FB_PRONTO_UNIT * F_CPU / 1000000.0;
+  int      pairs = (c->count + 1) / 2, len = 8;
+  uint16_t w[4] = {0x0000, word, pairs, 0};
+  for(int i=0; i<4; i++) { out[2 * i] = w[i]; out[2 * i + 1] = w[i] >> 8; }
+  for(int i=0; i<2*pairs; i++) {
+    double periods = (i < c->count) ? c->edge[i] / period + 0.5
+                                      : FB_LEADOUT * (F_CPU / 1000000.0) / period;
+    if(periods > 0xFFFF) return 0;
+    if(periods < 1) periods = 1;
+    out[len++] = (uint16_t)periods; out[len++] = (uint16_t)periods >> 8;
+  }
+  return len;
+}
+
+static int fb_prontoLoad(const uint8_t* p, uint32_t* out) {
+  uint16_t word = p[2] | p[3] << 8;
+  int      n = 0, count = 2 * (p[4] | p[5] << 8);
+  // Period in 1/256 ticks: word * unit * ticks per us * 256, scaled by 2^8 again
+  uint32_t factor = FB_PRONTO_UNIT * F_CPU / 1000000.0 * 65536 + 0.5;
+  fb_cycles += 2 * CY_LOAD + 2 * CY_ALU + CY_JUMP;   // lhu header, li, mv, jal
+  uint32_t period = fb_mul(factor, word) >> 8;
+  fb_cycles += CY_JUMP + CY_ALU + CY_ALU;            // ret, srli, addi
+  fb_mark = fb_cycles;
+  p += 8;
+  while(count--) {
+    uint16_t periods = p[0] | p[1] << 8;
+    p += 2;
+    fb_cycles += CY_LOAD + CY_ALU + 2 * CY_ALU + CY_JUMP;  // lhu, addi, mv, mv, jal
+    uint32_t t = (fb_mul(period, periods) + 128) >> 8;
+    fb_cycles += CY_JUMP + 2 * CY_ALU + CY_ALU + CY_JUMP;  // ret, addi, srli, addi, bnez
+    fb_edge(out, &n, t);
+  }
+  return n;
+}
+
+// ===================================================================================
+// Evaluation
+// ===================================================================================
+static void fb_count(FB_stat_t* s, int bytes, int edges, double err, double errMax) {
+  s->codes++;
+  s->bytes  += bytes;
+  s->edges  += edges;
+  s->cycles += fb_cycles;
+  s->err    += err;
+  if(bytes    > s->bytesMax)  s->bytesMax  = bytes;
+  if(fb_worst > s->cyclesMax) s->cyclesMax = fb_worst;
+  if(errMax   > s->errMax)    s->errMax    = errMax;
+}
+
+// Store the code in each format, load it again and compare with the nominal timing
+static void fb_evaluate(const FB_code_t* c) {
+  static uint8_t  data[FB_BYTES];
+  static uint32_t out[FB_EDGES + 1];
+  for(int f=0; f<FB_FORMATS; f++) {
+    int bytes = 0, n = 0;
+    fb_cycles = fb_mark = 0; fb_worst = 0;
+    switch(f) {
+      case FB_RAW:      if((bytes = fb_rawStore(c, data)))    n = fb_rawLoad(data, out);
+                        break;
+      case FB_DICT_RLE: if((bytes = fb_dictStore(c, data)))   n = fb_dictLoad(data, out);
+                        break;
+      case FB_PRONTO:   if((bytes = fb_prontoStore(c, data))) n = fb_prontoLoad(data, out);
+                        break;
+      case FB_PROTO:                                   // the encoder sends the nominal edges
+        if(!c->params) break;
+        bytes = c->params;
+        n = c->count;
+        memcpy(out, c->ref, n * sizeof(uint32_t));
+        fb_cycles = FB_PROTO_SETUP + n * fb_protoCycles[c->group];
+        fb_worst  = fb_protoCycles[c->group];
+        break;
+    }
+    if(!bytes) continue;                             // not storable in this format
+    if(n < c->count) {
+      fprintf(stderr, "%s: %s code decoded to %d of %d edges\n", fb_formats[f],
+              fb_groups[c->group], n, c->count);
+      exit(1);
+    }
+    double err = 0, errMax = 0;
+    for(int i=0; i<c->count; i++) {
+      double e = fabs((double)out[i] - c->ref[i]) * 1000000.0 / F_CPU;
+      err += e;
+      if(e > errMax) errMax = e;
+    }
+    fb_count(&fb_stat[c->group][f],  bytes, c->count, err, errMax);
+    fb_count(&fb_stat[FB_GROUPS][f], bytes, c->count, err, errMax);
+  }
+}
+
+// ===================================================================================
+// Corpus
+// ===================================================================================
+static double fb_random(void) {
+  return rand() / (RAND_MAX + 1.0);
+}
+
+// Distort the nominal edges like a learned code
+static void fb_distort(FB_code_t* c) {
+  for(int i=0; i<c->count; i++) {
+    double us = c->ref[i] * 1000000.0 / F_CPU;
+    us += (i & 1) ? -fb_extend : fb_extend;
+    us += fb_jitter * (2 * fb_random() - 1);
+    c->edge[i] = (us > 0) ? us * F_CPU / 1000000.0 + 0.5 : 0;
+    if(!c->edge[i]) c->edge[i] = 1;
+  }
+}
+
+// Send a code with random parameters by the encoder of the group, i selects variants
+static void fb_generate(int group, int i) {
+  static const uint8_t sonBits[3] = {12, 15, 20}, rmmBits[3] = {12, 24, 32};
+  uint32_t r = (uint32_t)rand() << 16 ^ rand();
+  memset(&fb_code, 0, sizeof(fb_code));
+  fb_code.group = group;
+  switch(group) {
+    case FB_NEC: {
+      uint16_t addr = (i & 1) ? 0x100 + (r >> 8) % 0xFF00 : (r >> 8) & 0xFF;
+      NEC_sendCode(addr, r);
+      fb_code.params = 1 + ((addr > 0xFF) ? 3 : 2);
+      break;
+    }
+    case FB_SAM:   SAM_sendCode(r, r >> 8);                       fb_code.params = 3; break;
+    case FB_SAM36: SAM36_sendCode(r, (r >> 16) & 0x0FFF);         fb_code.params = 5; break;
+    case FB_SAM48: SAM48_sendCode(r, r >> 16);                    fb_code.params = 5; break;
+    case FB_RC5:   RC5_sendCode(r & 0x1F, (r >> 8) & 0x7F);       fb_code.params = 3; break;
+    case FB_SON: {
+      uint8_t bits = sonBits[i % 3];
+      SON_sendCode((r >> 8) & ((1 << (bits - 7)) - 1), r & 0x7F, bits);
+      fb_code.params = 1 + ((bits > 16) ? 3 : 2);
+      break;
+    }
+    case FB_LPF:   LPF_sendCode(r & 3, (r >> 2) & 0x1F, (r >> 8) & 0x0F); fb_code.params = 3;
+                   break;
+    case FB_RMM: {
+      uint8_t bits = rmmBits[i % 3];
+      RMM_sendCode(r, bits);
+      fb_code.params = 1 + (bits + 7) / 8;
+      break;
+    }
+    case FB_XMP:   XMP_sendCode(r, r >> 8, r >> 16, rand());      fb_code.params = 6; break;
+  }
+  if(!(fb_code.count & 1)) fb_code.count--;          // drop the final space
+  fb_distort(&fb_code);
+}
+
+// Load codes from a file (Pronto hex or raw timings in us)
+static int fb_load(const char* file) {
+  static char line[16384];
+  FILE* f = fopen(file, "r");
+  int codes = 0;
+  if(!f) return -1;
+  while(fgets(line, sizeof(line), f)) {
+    char* p = line;
+    double us[FB_EDGES + 1];
+    int n = 0;
+    while(isspace((unsigned char)*p)) p++;
+    if(!*p || *p == '#') continue;
+    memset(&fb_code, 0, sizeof(fb_code));
+    fb_code.group = FB_FILE;
+    if(!strncmp(p, "0000 ", 5)) {                    // Pronto: 0000 freq once repeat
+      uint32_t w[4];
+      for(int i=0; i<4; i++) w[i] = strtoul(p, &p, 16);
+      double period = w[1] * FB_PRONTO_UNIT;
+      int pairs = w[2] ? w[2] : w[3];                // once sequence, else repeat
+      if(!w[1] || !pairs) continue;
+      fb_code.freq = 1000000.0 / period + 0.5;
+      while(n < 2 * pairs && n < FB_EDGES) {
+        char* end;
+        uint32_t v = strtoul(p, &end, 16);
+        if(end == p) break;
+        us[n++] = v * period;
+        p = end;
+      }
+    }
+    else {                                           // raw: freq mark space ...
+      fb_code.freq = strtoul(p, &p, 10);
+      while(n < FB_EDGES) {
+        char* end;
+        double v = strtod(p, &end);
+        if(end == p) break;
+        us[n++] = fabs(v);                           // some tools sign the spaces
+        p = end;
+      }
+    }
+    if(!(n & 1)) n--;                                // drop the final space
+    if(n < 1 || !fb_code.freq) continue;
+    for(int i=0; i<n; i++) {
+      uint32_t t = us[i] * F_CPU / 1000000.0 + 0.5;
+      fb_code.ref[i] = fb_code.edge[i] = t ? t : 1;
+    }
+    fb_code.count = n;
+    fb_evaluate(&fb_code);
+    codes++;
+  }
+  fclose(f);
+  return codes;
+}
+
+// ===================================================================================
+// Report
+// ===================================================================================
+static void fb_report(int verbose) {
+  const FB_stat_t* all = fb_stat[FB_GROUPS];
+  double codes = all[FB_RAW].codes;
+  printf("Corpus: %.0f codes, %.1f edges per code, F_CPU %d Hz\n", codes,
+         all[FB_RAW].edges / codes, F_CPU);
+  printf("Distortion: marks %+.0f us, jitter %.0f us, dictionary tolerance %.0f%%\n\n",
+         fb_extend, fb_jitter, fb_tol * 100);
+  printf("%-9s %6s  %10s %5s  %10s  %11s %4s  %9s %6s\n", "Format", "Codes",
+         "Bytes/code", "max", "Codes/16kB", "Cycles/edge", "max", "Error/us", "max");
+  for(int f=0; f<FB_FORMATS; f++) {
+    const FB_stat_t* s = &all[f];
+    if(!s->codes) { printf("%-9s %6d\n", fb_formats[f], 0); continue; }
+    printf("%-9s %6d  %10.1f %5d  %10.0f  %11.1f %4d  %9.2f %6.2f\n", fb_formats[f],
+           s->codes, s->bytes / s->codes, s->bytesMax, 16384 * s->codes / s->bytes,
+           s->cycles / s->edges, s->cyclesMax, s->err / s->edges, s->errMax);
+  }
+  if(!verbose) return;
+  printf("\nBytes per code (mean timing error in us):\n%-10s", "");
+  for(int f=0; f<FB_FORMATS; f++) printf("  %-15s", fb_formats[f]);
+  printf("\n");
+  for(int g=0; g<FB_GROUPS; g++) {
+    if(!fb_stat[g][FB_RAW].codes) continue;
+    printf("%-10s", fb_groups[g]);
+    for(int f=0; f<FB_FORMATS; f++) {
+      const FB_stat_t* s = &fb_stat[g][f];
+      if(s->codes) printf("  %6.1f (%5.2f) ", s->bytes / s->codes, s->err / s->edges);
+      else         printf("  %-15s", "-");
+    }
+    printf("\n");
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* files[FB_FILES];
+  int opt, codes = 500, nfiles = 0, verbose = 0;
+  unsigned seed = time(NULL);
+
+  while((opt = getopt(argc, argv, "n:x:j:q:f:vs:")) != -1) {
+    switch(opt) {
+      case 'n': codes     = atoi(optarg);        break;
+      case 'x': fb_extend = atof(optarg);        break;
+      case 'j': fb_jitter = atof(optarg);        break;
+      case 'q': fb_tol    = atof(optarg) / 100;  break;
+      case 'f': if(nfiles < FB_FILES) files[nfiles++] = optarg; break;
+      case 'v': verbose   = 1;                   break;
+      case 's': seed      = atoi(optarg);        break;
+      default:
+        fprintf(stderr, "Usage: %s [-n codes] [-x us] [-j us] [-q tolerance%%] [-f file] "
+                        "[-v] [-s seed]\n", argv[0]);
+        return 2;
+    }
+  }
+  srand(seed);
+
+  for(int i=0; i<codes; i++) {
+    for(int g=0; g<FB_FILE; g++) {
+      fb_generate(g, i);
+      fb_evaluate(&fb_code);
+    }
+  }
+  for(int i=0; i<nfiles; i++) {
+    if(fb_load(files[i]) < 0) {
+      fprintf(stderr, "%s: can't read %s\n", argv[0], files[i]);
+      return 2;
+    }
+  }
+  if(!fb_stat[FB_GROUPS][FB_RAW].codes) {
+    fprintf(stderr, "%s: no codes\n", argv[0]);
+    return 2;
+  }
+  fb_report(verbose);
+  return 0;
+}
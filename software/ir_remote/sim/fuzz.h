@@ -0,0 +1,130 @@
+// ===================================================================================
+// Standalone Driver for the Fuzz Harnesses (Host)
+// ===================================================================================
+//
+// The harnesses sim/fuzz_*.c implement LLVMFuzzerTestOneInput() for libFuzzer. If
+// they are compiled with FUZZ_STANDALONE (e.g. with gcc, where libFuzzer is not
+// available), this driver provides main():
+//
+//   fuzz_x file...           run the harness on each file (e.g. to reproduce a crash)
+//   fuzz_x -g dir            write the seed corpus of the harness into dir
+//   fuzz_x -r runs [-s seed] run random mutations of the seed corpus
+//
+// Each harness provides fuzz_seeds(), which calls fuzz_seed() for every seed input.
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+int  LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+void fuzz_seeds(void);                        // provided by the harness
+void fuzz_seed(const uint8_t* data, size_t size);
+
+#ifdef FUZZ_STANDALONE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#define FUZZ_MAX          4096                // max input size
+#define FUZZ_SEEDS        64                  // max number of seeds
+
+static uint8_t* fuzz_corpus[FUZZ_SEEDS];
+static size_t   fuzz_sizes[FUZZ_SEEDS];
+static int      fuzz_count;
+static const char* fuzz_dir;
+
+// Add seed to corpus (and write it to fuzz_dir)
+void fuzz_seed(const uint8_t* data, size_t size) {
+  if(fuzz_count == FUZZ_SEEDS) return;
+  if(size > FUZZ_MAX) size = FUZZ_MAX;
+  fuzz_corpus[fuzz_count] = malloc(size + 1);
+  memcpy(fuzz_corpus[fuzz_count], data, size);
+  fuzz_sizes[fuzz_count] = size;
+  if(fuzz_dir) {
+    char name[512];
+    snprintf(name, sizeof(name), "%s/seed%02d", fuzz_dir, fuzz_count);
+    FILE* f = fopen(name, "wb");
+    if(f) {
+      fwrite(data, 1, size, f);
+      fclose(f);
+    }
+  }
+  fuzz_count++;
+}
+
+// Mutate input: flip bits, change bytes, cut, insert or duplicate blocks
+static size_t fuzz_mutate(uint8_t* buf, size_t size) {
+  for(int k=rand() % 8 + 1; k; k--) {
+    size_t pos = size ? rand() % size : 0;
+    switch(rand() % 6) {
+      case 0: if(size) buf[pos] ^= 1 << (rand() % 8);              break;
+      case 1: if(size) buf[pos] = rand();                           break;
+      case 2: if(size) buf[pos] = (rand() & 1) ? 0x00 : 0xff;       break;
+      case 3: size = pos;                                           break;
+      case 4: if(size < FUZZ_MAX) {
+                memmove(buf + pos + 1, buf + pos, size - pos);
+                buf[pos] = rand(); size++;
+              }
+              break;
+      case 5: {
+                size_t len = rand() % 64;
+                if(size + len > FUZZ_MAX || pos + len > size) break;
+                memmove(buf + pos + len, buf + pos, size - pos);
+                size += len;
+              }
+              break;
+    }
+  }
+  return size;
+}
+
+int main(int argc, char** argv) {
+  static uint8_t buf[FUZZ_MAX + 64];
+  int opt;
+  long runs = 0;
+  unsigned seed = time(NULL);
+  while((opt = getopt(argc, argv, "g:r:s:")) != -1) {
+    switch(opt) {
+      case 'g': fuzz_dir = optarg;       break;
+      case 'r': runs = atol(optarg);     break;
+      case 's': seed = atoi(optarg);     break;
+      default:
+        fprintf(stderr, "Usage: %s [file...] [-g dir] [-r runs] [-s seed]\n", argv[0]);
+        return 2;
+    }
+  }
+  fuzz_seeds();
+  for(int i=optind; i<argc; i++) {            // run files
+    FILE* f = fopen(argv[i], "rb");
+    if(!f) { perror(argv[i]); return 2; }
+    size_t size = fread(buf, 1, FUZZ_MAX, f);
+    fclose(f);
+    LLVMFuzzerTestOneInput(buf, size);
+  }
+  for(int i=0; i<fuzz_count; i++) LLVMFuzzerTestOneInput(fuzz_corpus[i], fuzz_sizes[i]);
+  srand(seed);
+  for(long r=0; r<runs; r++) {                // random mutations of the seeds
+    size_t size = 0;
+    if(fuzz_count && rand() % 16) {
+      int i = rand() % fuzz_count;
+      size = fuzz_sizes[i];
+      memcpy(buf, fuzz_corpus[i], size);
+    }
+    size = fuzz_mutate(buf, size);
+    uint8_t* input = malloc(size + 1);        // exact size, overruns are caught by ASan
+    memcpy(input, buf, size);
+    LLVMFuzzerTestOneInput(input, size);
+    free(input);
+  }
+  printf("%d seeds, %d files, %ld mutations, seed %u: ok\n", fuzz_count, argc - optind,
+         runs, seed);
+  return 0;
+}
+#else
+void fuzz_seed(const uint8_t* data, size_t size) {
+  (void)data; (void)size;
+}
+#endif  // FUZZ_STANDALONE
@@ -0,0 +1,97 @@
+// ===================================================================================
+// Fuzz Harness for the Clone Receiver (Host)
+// ===================================================================================
+//
+// CLONE_receive() parses whatever arrives at the IrDA transceiver. The input of the
+// fuzzer is the byte stream on the link: the first two bytes give the size of the
+// receive buffer (1..CLONE_SIZE), the rest is returned byte by byte by
+// CLONE_HOST_getc(), a timeout follows at the end. The buffer is allocated with
+// exactly that size, so ASan catches any write behind it. The harness aborts if the
+// receiver keeps reading after the input is exhausted (no progress) or returns more
+// bytes than fit into the buffer.
+//
+// The seed corpus consists of complete transfers of CLONE_send() (recorded by this
+// harness) with and without lost frames.
+//
+// Build:  make fuzz  (see sim/fuzz.h)
+
+#include <stdlib.h>
+#include <string.h>
+#include "clone.h"
+#include "fuzz.h"
+
+#define FUZZ_POLLS        1000                // max timeouts after end of input
+
+static const uint8_t* fz_data;                // link input
+static size_t         fz_size, fz_pos, fz_timeouts;
+static uint8_t*       fz_rec;                 // recording of CLONE_send (seeds)
+static size_t         fz_recsize, fz_reccap;
+static int            fz_drop;                // drop every fz_drop-th frame (seeds)
+static int            fz_frame;
+
+// ===================================================================================
+// Host Link Backend
+// ===================================================================================
+void CLONE_HOST_begin(void) {
+  fz_frame++;
+}
+
+void CLONE_HOST_putc(uint8_t data) {
+  if(!fz_rec) return;                         // receiver answers are discarded
+  if(fz_drop && fz_frame % fz_drop == 0) return;
+  if(fz_recsize == fz_reccap) {
+    fz_reccap = fz_reccap ? fz_reccap * 2 : 1024;
+    fz_rec = realloc(fz_rec, fz_reccap);
+  }
+  fz_rec[fz_recsize++] = data;
+}
+
+void CLONE_HOST_end(void) {
+}
+
+int CLONE_HOST_getc(uint16_t timeout) {
+  (void)timeout;
+  if(fz_rec) return -1;                       // seeds: ACK never arrives
+  if(fz_pos < fz_size) return fz_data[fz_pos++];
+  if(++fz_timeouts > FUZZ_POLLS) abort();     // no progress at the end of the input
+  return -1;
+}
+
+void CLONE_HOST_turn(void) {
+}
+
+// ===================================================================================
+// Harness
+// ===================================================================================
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+  uint16_t max, len;
+  uint8_t* buf;
+  if(size < 2) return 0;
+  max = (data[0] | data[1] << 8) % CLONE_SIZE + 1;
+  fz_data = data + 2; fz_size = size - 2; fz_pos = 0; fz_timeouts = 0;
+  buf = malloc(max);
+  len = CLONE_receive(buf, max);
+  if(len > max) abort();
+  free(buf);
+  return 0;
+}
+
+// Seeds: transfers of different sizes, some with lost frames
+void fuzz_seeds(void) {
+  static const uint16_t sizes[] = {1, CLONE_BLOCK, 100, CLONE_SIZE};
+  static const int drops[] = {0, 3};
+  uint8_t data[CLONE_SIZE];
+  for(int i=0; i<CLONE_SIZE; i++) data[i] = i * 7;
+  for(size_t s=0; s<sizeof(sizes)/sizeof(sizes[0]); s++) {
+    for(size_t d=0; d<sizeof(drops)/sizeof(drops[0]); d++) {
+      fz_reccap = 1024; fz_rec = malloc(fz_reccap);
+      fz_rec[0] = (CLONE_SIZE - 1) & 0xff;    // receive buffer of max size
+      fz_rec[1] = (CLONE_SIZE - 1) >> 8;
+      fz_recsize = 2; fz_drop = drops[d]; fz_frame = 0;
+      fz_size = 0; fz_pos = 0; fz_timeouts = 0;
+      CLONE_send(data, sizes[s]);             // no ACK: first round and all polls
+      fuzz_seed(fz_rec, fz_recsize);
+      free(fz_rec); fz_rec = NULL;
+    }
+  }
+}
@@ -0,0 +1,375 @@
+// ===================================================================================
+// Round-Trip Check of the Timed IR Encoders (Host)
+// ===================================================================================
+//
+// Sends codes with the encoders of src/protocols.c, records the marks and spaces by
+// the IR_HOST backend of src/ir.c and decodes them again with sim/decoders.c (NEC,
+// Samsung, RC-5, SIRC, RC-MM, XMP, Samsung36/48). Each code is sent with one repeat,
+// so that the repeat frames (NEC: the repeat code) are checked as well. LEGO Power
+// Functions is checked for the start times of its five messages on each channel. The
+// largest deviation of an edge from its nominal length is reported, on the host this
+// is only the rounding to system ticks (1 / F_CPU).
+//
+// Afterwards every protocol (and a long air conditioner frame of 144 bits, sent by
+// PD_send) is held for 0.5s and passed through the receiver model of sim/receiver.c.
+// The table shows for each AGC class whether the receiver would cut or suppress marks.
+// These are warnings about the risk with a class of receivers, not failures.
+//
+// Finally the test sequence of the factory test mode (src/factory.c) is recorded, its
+// length is checked against the test window of 1s and its report is decoded.
+//
+// Build:  make sim  (or: cc -O2 -DIR_HOST -I. -Isrc -Isim -o bin/ir_check sim/ir_check.c
+//                        sim/decoders.c sim/receiver.c src/protocols.c src/factory.c
+//                        src/ir.c -lm)
+// Usage:  bin/ir_check [-n codes] [-s seed]
+//
+// The exit status is 1 if any code was not decoded correctly.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <math.h>
+#include "protocols.h"
+#include "factory.h"
+#include "decoders.h"
+#include "receiver.h"
+
+static int chk_repeats;                       // remaining repeats of KEY_read()
+static int chk_failed;
+static double chk_err;                        // largest edge deviation in us
+static uint32_t chk_freq;                     // carrier frequency
+static double chk_time, chk_hold;             // recorded time and hold time in us
+static uint8_t chk_toggle;                      // expected RC-5 toggle bit
+
+// ===================================================================================
+// Host Backends
+// ===================================================================================
+void IR_HOST_carrier(uint32_t freq) {
+  chk_freq = freq;
+}
+
+void IR_HOST_edge(uint8_t mark, uint32_t ticks) {
+  DEC_record(mark, ticks * 1000000.0 / F_CPU);
+  chk_time += ticks * 1000000.0 / F_CPU;
+}
+
+uint8_t KEY_read(void) {
+  if(chk_hold > 0) return chk_time < chk_hold;
+  return chk_repeats-- > 0;
+}
+
+static const uint32_t chk_uid[3] = {0x12345678, 0x9ABCDEF0, 0x0F1E2D3C};
+
+void FACTORY_HOST_info(uint32_t* uid, uint16_t* vdd, uint32_t* hash) {
+  for(int i=0; i<3; i++) uid[i] = chk_uid[i];
+  *vdd  = 3012;
+  *hash = 0xCAFEBABE;
+}
+
+// ===================================================================================
+// Checks
+// ===================================================================================
+static void chk_result(const char* name, int ok, double err, uint32_t code) {
+  if(err > chk_err) chk_err = err;
+  if(ok) return;
+  printf("%s: code 0x%08X not decoded\n", name, code);
+  chk_failed++;
+}
+
+// Send NEC telegram with one repeat code and decode frame and repeat
+static void chk_NEC(uint16_t addr, uint8_t cmd) {
+  uint16_t raddr;
+  uint8_t  rcmd, rrepeat;
+  double   err;
+  int      ok = 1, pos = 0, used;
+  if(((addr ^ (addr >> 8)) & 0xff) == 0xff) addr &= 0xff;  // 8-bit address + inverse
+  DEC_clear();
+  chk_repeats = 1;
+  NEC_sendCode(addr, cmd);
+  for(int frame=0; frame<2; frame++) {
+    used = DEC_NEC(DEC_edges + pos, DEC_count - pos, &raddr, &rcmd, &rrepeat, &err);
+    ok &= used && rrepeat == frame && (frame || (raddr == addr && rcmd == cmd));
+    pos += used;
+    chk_result("NEC", ok, err, (uint32_t)addr << 16 | cmd);
+  }
+}
+
+// Send RC-5 telegram with one repeat and decode both frames, the toggle bit changes
+// with each key press only
+static void chk_RC5(uint8_t addr, uint8_t cmd) {
+  uint8_t  raddr, rcmd, rtoggle;
+  double   err;
+  int      ok = 1, pos = 0, used;
+  addr &= 0x1f; cmd &= 0x7f;
+  DEC_clear();
+  chk_repeats = 1;
+  RC5_sendCode(addr, cmd);
+  for(int frame=0; frame<2; frame++) {
+    if(pos < DEC_count && !DEC_edges[pos].mark) pos++;  // first half of the start bit
+    used = DEC_RC5(DEC_edges + pos, DEC_count - pos, &raddr, &rcmd, &rtoggle, &err);
+    ok &= used && raddr == addr && rcmd == cmd && rtoggle == chk_toggle;
+    pos += used;
+    chk_result("RC-5", ok, err, (uint32_t)addr << 16 | cmd);
+  }
+  chk_toggle ^= 1;
+}
+
+// Send SIRC telegram with one repeat and decode both frames
+static void chk_SON(uint16_t addr, uint8_t cmd, uint8_t bits) {
+  uint16_t raddr;
+  uint8_t  rcmd, rbits;
+  double   err;
+  int      ok = 1, pos = 0, used;
+  addr &= ((uint16_t)1 << (bits - 7)) - 1; cmd &= 0x7f;
+  DEC_clear();
+  chk_repeats = 1;
+  SON_sendCode(addr, cmd, bits);
+  for(int frame=0; frame<2; frame++) {
+    used = DEC_SON(DEC_edges + pos, DEC_count - pos, &raddr, &rcmd, &rbits, &err);
+    ok &= used && raddr == addr && rcmd == cmd && rbits == bits;
+    pos += used;
+    chk_result(bits == 12 ? "SIRC-12" : bits == 15 ? "SIRC-15" : "SIRC-20", ok, err,
+               (uint32_t)addr << 16 | cmd);
+  }
+}
+
+// Send LEGO Power Functions message (five times, key released) and check the start
+// of each message against the repeat schedule of channel ch (Ch = ch + 1, tm = 16ms):
+// (4 - Ch) * tm before message 1, 5 * tm before messages 2 and 3, (6 + 2 * Ch) * tm
+// before messages 4 and 5. Each message has 18 marks (start, 16 bits, stop).
+static void chk_LPF(uint8_t ch) {
+  static const char* names[4] = {"LEGO PF ch1", "LEGO PF ch2", "LEGO PF ch3",
+                                 "LEGO PF ch4"};
+  double start[6], t = 0, expect = 0;
+  int    ok = 1, marks = 0, msgs = 0;
+  DEC_clear();
+  chk_repeats = 0;
+  LPF_sendCode(ch, 0x04, 0x7);
+  for(int i=0; i<DEC_count; i++) {
+    if(DEC_edges[i].mark && marks++ % 18 == 0 && msgs < 6) start[msgs++] = t;
+    t += DEC_edges[i].us;
+  }
+  ok &= msgs == 5 && marks == 5 * 18;
+  for(int m=0; m<msgs && m<5; m++) {
+    expect += ((m == 0) ? 4 - (ch + 1) : (m < 3) ? 5 : 6 + 2 * (ch + 1)) * 16000.0;
+    if(fabs(start[m] - expect) > 1e6 / F_CPU) {
+      printf("%s: message %d starts at %.0fus, not %.0fus\n", names[ch], m + 1,
+             start[m], expect);
+      ok = 0;
+    }
+  }
+  chk_result(names[ch], ok, 0, ch);
+}
+
+// Send RC-MM frame with one repeat and decode both frames
+static void chk_RMM(uint32_t data, uint8_t bits) {
+  uint32_t rdata;
+  uint8_t  rbits;
+  double   err;
+  int      ok = 1, pos = 0, used;
+  data &= (bits == 32) ? 0xFFFFFFFF : (((uint32_t)1 << bits) - 1);
+  DEC_clear();
+  chk_repeats = 1;
+  RMM_sendCode(data, bits);
+  for(int frame=0; frame<2; frame++) {
+    used = DEC_RMM(DEC_edges + pos, DEC_count - pos, &rdata, &rbits, &err);
+    ok &= used && rdata == data && rbits == bits;
+    if(frame == 0 && used) {                  // start-to-start interval
+      double t = 0;
+      for(int i=0; i<used; i++) t += DEC_edges[i].us;
+      ok &= t > 27700 && t < 27850;
+    }
+    pos += used;
+    chk_result("RC-MM", ok, err, data);
+  }
+}
+
+// Send XMP telegram with one repeat and decode both frames
+static void chk_XMP(uint8_t oem, uint8_t dev, uint8_t sub, uint16_t func) {
+  uint8_t  roem, rdev, rsub, rtoggle;
+  uint16_t rfunc;
+  double   err;
+  int      ok = 1, pos = 0, used;
+  DEC_clear();
+  chk_repeats = 1;
+  XMP_sendCode(oem, dev, sub, func);
+  for(int frame=0; frame<2; frame++) {
+    used = DEC_XMP(DEC_edges + pos, DEC_count - pos, &roem, &rdev, &rsub, &rfunc,
+                   &rtoggle, &err);
+    ok &= used && roem == oem && rdev == dev && rsub == sub && rfunc == func
+       && rtoggle == (frame ? 8 : 0);
+    pos += used;
+    chk_result("XMP", ok, err, (uint32_t)sub << 24 | oem << 16 | func);
+  }
+}
+
+// Send Samsung/Samsung36/48 telegram with one repeat and decode both frames
+static void chk_SAM(uint8_t bits, uint16_t addr, uint16_t cmd) {
+  uint16_t raddr, rcmd;
+  uint8_t  raddr8, rcmd8;
+  double   err;
+  int      ok = 1, pos = 0, used;
+  if(bits == 32) {addr &= 0xff; cmd &= 0xff;}
+  if(bits == 36) cmd &= 0x0fff;
+  DEC_clear();
+  chk_repeats = 1;
+  if(bits == 32)      SAM_sendCode(addr, cmd);
+  else if(bits == 36) SAM36_sendCode(addr, cmd);
+  else                SAM48_sendCode(addr, cmd);
+  for(int frame=0; frame<2; frame++) {
+    const DEC_edge_t* e = DEC_edges + pos;
+    int n = DEC_count - pos;
+    if(bits == 32) {
+      used = DEC_SAM(e, n, &raddr8, &rcmd8, &err);
+      raddr = raddr8; rcmd = rcmd8;
+    }
+    else used = (bits == 36) ? DEC_SAM36(e, n, &raddr, &rcmd, &err)
+                             : DEC_SAM48(e, n, &raddr, &rcmd, &err);
+    ok &= used && raddr == addr && rcmd == cmd;
+    if(bits == 48 && frame == 0 && used) {    // start-to-start interval
+      double t = 0;
+      for(int i=0; i<used; i++) t += DEC_edges[i].us;
+      ok &= t > 107900 && t < 108100;
+    }
+    pos += used;
+    chk_result(bits == 32 ? "Samsung" : bits == 36 ? "Samsung36" : "Samsung48", ok, err,
+               (uint32_t)addr << 16 | cmd);
+  }
+}
+
+// ===================================================================================
+// AGC Risk Report
+// ===================================================================================
+
+// Air conditioner frame: 144 bits, NEC-like timing (like long A/C remotes)
+static const PD_protocol_t chk_AC_protocol = {
+  .hdrMark   = IR_ticks(3400),
+  .hdrSpace  = IR_ticks(1750),
+  .bitMark   = IR_ticks(450),
+  .zeroSpace = IR_ticks(420),
+  .oneSpace  = IR_ticks(1300),
+  .stopMark  = IR_ticks(450),
+  .stopSpace = IR_ticks(17000),
+  .flags     = PD_LSB_FIRST
+};
+
+static void chk_AC(void) {
+  static const uint8_t data[18] = {0x23, 0xCB, 0x26, 0x01, 0x00, 0x20, 0x08, 0x06,
+                                   0x30, 0x45, 0x67, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                   0x00, 0x4F};
+  IR_HOST_carrier(38000);
+  IR_start();
+  do {
+    PD_send(&chk_AC_protocol, data, 144);
+  } while(KEY_read());
+}
+
+// Hold key for 0.5s while sending the code, check with each receiver class
+static void chk_AGC(const char* name, int code) {
+  DEC_clear();
+  chk_time = 0; chk_hold = 500000;
+  switch(code) {
+    case 0: NEC_sendCode(0x04, 0x08);                    break;
+    case 1: SAM_sendCode(0x07, 0x02);                    break;
+    case 2: SAM36_sendCode(0x0707, 0x0102);              break;
+    case 3: SAM48_sendCode(0x0707, 0x0102);              break;
+    case 4: RC5_sendCode(0x00, 0x0B);                    break;
+    case 5: SON_sendCode(0x01, 0x15, 12);                break;
+    case 6: LPF_sendCode(0, 0x04, 0x7);                  break;
+    case 7: RMM_sendCode(0x123456, 24);                  break;
+    case 8: XMP_sendCode(0x44, 0x12, 0x03, 0x1234);      break;
+    case 9: chk_AC();                                    break;
+  }
+  chk_hold = 0;
+  printf("%-10s", name);
+  for(int c=0; c<RX_count; c++) {
+    printf("  %-12s", RX_describe(RX_filter(&RX_classes[c], chk_freq, DEC_edges,
+                                             DEC_count, NULL)));
+  }
+  printf("\n");
+}
+
+static void chk_AGC_report(void) {
+  static const char* names[] = {"NEC", "Samsung", "Samsung36", "Samsung48", "RC-5",
+                                "SIRC", "LEGO PF", "RC-MM", "XMP", "AC-144"};
+  printf("\nAGC risk (key held for 0.5s):\n%-10s", "");
+  for(int c=0; c<RX_count; c++) printf("  %-12s", RX_classes[c].name);
+  printf("\n");
+  for(int i=0; i<10; i++) chk_AGC(names[i], i);
+}
+
+// ===================================================================================
+// Factory Test Sequence
+// ===================================================================================
+static void chk_FACTORY(void) {
+  uint8_t report[FACTORY_REPORT];
+  double  err = 0;
+  int     ok = 0;
+  DEC_clear();
+  chk_time = 0;
+  FACTORY_run();
+  for(int i=0; i<DEC_count && !ok; i++) {     // report is the last frame
+    if(DEC_FACTORY(DEC_edges + i, DEC_count - i, report, FACTORY_REPORT, &err)) {
+      ok = report[0] == FACTORY_VERSION
+        && report[1] == 0x78 && report[12] == 0x0F            // UID
+        && (report[13] | report[14] << 8) == 3012              // VDD
+        && (report[15] | report[18] << 24) == (0xBE | 0xCA << 24);  // hash
+    }
+  }
+  ok &= chk_time < 1000000;
+  printf("\nFactory test sequence: %.1f ms, report %s\n", chk_time / 1000,
+         ok ? "ok" : "FAILED");
+  if(!ok) chk_failed++;
+}
+
+int main(int argc, char** argv) {
+  static const uint8_t bits[3] = {12, 24, 32};
+  static const uint8_t sbits[3] = {12, 15, 20};
+  int opt, codes = 1000;
+  unsigned seed = time(NULL);
+
+  while((opt = getopt(argc, argv, "n:s:")) != -1) {
+    switch(opt) {
+      case 'n': codes = atoi(optarg); break;
+      case 's': seed  = atoi(optarg); break;
+      default:
+        fprintf(stderr, "Usage: %s [-n codes] [-s seed]\n", argv[0]);
+        return 2;
+    }
+  }
+  srand(seed);
+
+  for(int i=0; i<codes; i++) {
+    uint32_t r = (uint32_t)rand() << 16 ^ rand();
+    chk_NEC(rand(), rand());
+    chk_SAM(32, rand(), rand());
+    chk_RC5(rand(), rand());
+    chk_SON(rand(), rand(), sbits[i % 3]);
+    chk_RMM(r, bits[i % 3]);
+    chk_XMP(rand(), rand(), rand(), rand());
+    chk_SAM(36, rand(), rand());
+    chk_SAM(48, rand(), rand());
+  }
+  chk_NEC(0, 0); chk_NEC(0xFFFF, 0xFF);
+  chk_SAM(32, 0, 0); chk_SAM(32, 0xFF, 0xFF);
+  chk_RC5(0, 0); chk_RC5(0x1F, 0x7F);
+  chk_SON(0, 0, 12); chk_SON(0x1FFF, 0x7F, 20);
+  for(int ch=0; ch<4; ch++) chk_LPF(ch);      // repeat schedule of each channel
+  chk_RMM(0, 12); chk_RMM(0xFFFFFFFF, 32);    // shortest and longest symbols
+  DEC_clear();                                // invalid RC-MM lengths send nothing
+  RMM_sendCode(0x123, 13); RMM_sendCode(0xFFFFFFFF, 40);
+  if(DEC_count) {
+    printf("RC-MM: frame of invalid length sent\n");
+    chk_failed++;
+  }
+  chk_XMP(0, 0, 0, 0); chk_XMP(0xFF, 0xFF, 0xFF, 0xFFFF);
+  chk_SAM(36, 0, 0); chk_SAM(36, 0xFFFF, 0x0FFF);
+  chk_SAM(48, 0, 0); chk_SAM(48, 0xFFFF, 0xFFFF);
+
+  printf("%d codes per protocol, seed %u, F_CPU %d Hz\n", codes + 2, seed, F_CPU);
+  printf("failed: %d, max edge deviation: %.2f us\n", chk_failed, chk_err);
+  chk_AGC_report();
+  chk_FACTORY();
+  return chk_failed ? 1 : 0;
+}
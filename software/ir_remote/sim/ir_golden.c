@@ -0,0 +1,209 @@
+// ===================================================================================
+// Golden Timing Vectors of the IR Encoders (Host)
+// ===================================================================================
+//
+// Sends fixed codes with the NEC, Samsung, RC-5 and SIRC encoders of src/protocols.c
+// and compares the marks and spaces recorded by the IR_HOST backend of src/ir.c edge
+// by edge with the expected sequences below. Adjacent edges of the same level are
+// merged, as a receiver would see them. The expected sequences are the nominal values
+// of the protocol specs (see the comments in src/protocols.c), including the pause
+// after the last frame. An edge passes if it is within GV_TOL system ticks, which
+// allows for the rounding of both merged edges to ticks. The carrier frequency is
+// checked as well.
+//
+// Covered: NEC with standard (8-bit + inverse) and extended (16-bit) address and a
+// repeat code, Samsung with double address, RC-5 with field bit 1 and 0 and both
+// states of the toggle bit, SIRC with 12, 15 and 20 bits.
+//
+// Build:  make check  (or: cc -O2 -DIR_HOST -I. -Isrc -Isim -o bin/ir_golden
+//                          sim/ir_golden.c src/protocols.c src/ir.c -lm)
+// Usage:  bin/ir_golden [-v]
+//
+// The exit status is 1 if any edge or carrier doesn't match. With -v, all recorded
+// edges are listed.
+
+#include <stdio.h>
+#include <unistd.h>
+#include <math.h>
+#include "protocols.h"
+
+#define GV_MAX            256                 // max number of recorded edges
+#define GV_TOL            2                   // tolerance per edge in system ticks
+#define GV_LEN(v)         (sizeof(v) / sizeof(double))
+
+static double   gv_edges[GV_MAX];             // recorded edges (+mark / -space) in us
+static int      gv_count;                     // number of recorded edges
+static int      gv_repeats;                   // remaining repeats of KEY_read()
+static uint32_t gv_freq;                      // carrier frequency
+static int      gv_verbose;
+
+// ===================================================================================
+// Host Backends
+// ===================================================================================
+void IR_HOST_carrier(uint32_t freq) {
+  gv_freq = freq;
+}
+
+// Record edge, merge with the previous edge of the same level
+void IR_HOST_edge(uint8_t mark, uint32_t ticks) {
+  double us = ticks * 1000000.0 / F_CPU;
+  if(!mark) us = -us;
+  if(gv_count && (gv_edges[gv_count - 1] > 0) == (us > 0)) {
+    gv_edges[gv_count - 1] += us;
+    return;
+  }
+  if(gv_count < GV_MAX) gv_edges[gv_count++] = us;
+}
+
+uint8_t KEY_read(void) {
+  return gv_repeats-- > 0;
+}
+
+// ===================================================================================
+// Golden Vectors (+mark / -space in us)
+// ===================================================================================
+
+// NEC, address 0x04, command 0x08, one repeat code
+static const double GV_NEC[] = {
+     +9000,    -4500,   +562.5,   -562.5,   +562.5,   -562.5,   +562.5,  -1687.5,
+    +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,   -562.5,
+    +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,  -1687.5,
+    +562.5,  -1687.5,   +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,
+    +562.5,  -1687.5,   +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,  -1687.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,  -1687.5,
+    +562.5,  -1687.5,   +562.5, -40562.5,    +9000,    -2250,   +562.5, -56562.5
+};
+// NEC extended, address 0x1234, command 0x56
+static const double GV_NECX[] = {
+     +9000,    -4500,   +562.5,   -562.5,   +562.5,   -562.5,   +562.5,  -1687.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,   -562.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,  -1687.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,   -562.5,   +562.5,  -1687.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,   -562.5,   +562.5,   -562.5,
+    +562.5,  -1687.5,   +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,   -562.5,
+    +562.5,  -1687.5,   +562.5,   -562.5
+};
+// Samsung, address 0x07 (sent twice), command 0x02
+static const double GV_SAM[] = {
+     +4500,    -4500,   +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,  -1687.5,
+    +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,  -1687.5,
+    +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,   +562.5,   -562.5,
+    +562.5,   -562.5,   +562.5,  -1687.5,   +562.5,   -562.5,   +562.5,  -1687.5,
+    +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,  -1687.5,   +562.5,  -1687.5,
+    +562.5,  -1687.5,   +562.5, -44562.5
+};
+// RC-5, address 0x05, command 0x35 (field bit 1), toggle 0
+static const double GV_RC5[] = {
+      -889,     +889,     -889,    +1778,     -889,     +889,     -889,     +889,
+     -1778,    +1778,    -1778,     +889,     -889,     +889,     -889,    +1778,
+     -1778,    +1778,    -1778,     +889,   -89108
+};
+// RC-5, address 0x05, command 0x75 (field bit 0), toggle 1
+static const double GV_RC5X[] = {
+      -889,    +1778,    -1778,    +1778,     -889,     +889,    -1778,    +1778,
+     -1778,     +889,     -889,     +889,     -889,    +1778,    -1778,    +1778,
+     -1778,     +889,   -89108
+};
+// SIRC-12, address 0x01, command 0x15
+static const double GV_SON12[] = {
+     +2400,     -600,    +1200,     -600,     +600,     -600,    +1200,     -600,
+      +600,     -600,    +1200,     -600,     +600,     -600,     +600,     -600,
+     +1200,     -600,     +600,     -600,     +600,     -600,     +600,     -600,
+      +600,   -27600
+};
+// SIRC-15, address 0xA4, command 0x15
+static const double GV_SON15[] = {
+     +2400,     -600,    +1200,     -600,     +600,     -600,    +1200,     -600,
+      +600,     -600,    +1200,     -600,     +600,     -600,     +600,     -600,
+      +600,     -600,     +600,     -600,    +1200,     -600,     +600,     -600,
+      +600,     -600,    +1200,     -600,     +600,     -600,    +1200,   -27600
+};
+// SIRC-20, address 0x3C, extended 0x0A, command 0x15
+static const double GV_SON20[] = {
+     +2400,     -600,    +1200,     -600,     +600,     -600,    +1200,     -600,
+      +600,     -600,    +1200,     -600,     +600,     -600,     +600,     -600,
+      +600,     -600,     +600,     -600,    +1200,     -600,    +1200,     -600,
+     +1200,     -600,    +1200,     -600,     +600,     -600,     +600,     -600,
+      +600,     -600,    +1200,     -600,     +600,     -600,    +1200,     -600,
+      +600,   -27600
+};
+
+// ===================================================================================
+// Checks
+// ===================================================================================
+
+// Compare recorded edges with expected edges, returns number of mismatches
+static int gv_compare(const char* name, const double* exp, int n, uint32_t freq) {
+  double tol = GV_TOL * 1000000.0 / F_CPU;
+  int failed = 0;
+  if(gv_verbose) {
+    printf("%s:", name);
+    for(int i=0; i<gv_count; i++) printf(" %+.2f", gv_edges[i]);
+    printf("\n");
+  }
+  if(gv_freq != freq) {
+    printf("%s: carrier %u Hz, expected %u Hz\n", name, gv_freq, freq);
+    failed++;
+  }
+  if(gv_count != n) {
+    printf("%s: %d edges, expected %d\n", name, gv_count, n);
+    failed++;
+  }
+  for(int i=0; i<n && i<gv_count; i++) {
+    if(fabs(gv_edges[i] - exp[i]) > tol) {
+      printf("%s: edge %d is %+.2f us, expected %+.2f us\n", name, i, gv_edges[i],
+             exp[i]);
+      failed++;
+    }
+  }
+  printf("%-10s %3d edges  %s\n", name, n, failed ? "FAILED" : "ok");
+  return failed;
+}
+
+// Start recording, KEY_read() returns 1 for the given number of repeats
+static void gv_start(int repeats) {
+  gv_count   = 0;
+  gv_freq    = 0;
+  gv_repeats = repeats;
+}
+
+int main(int argc, char** argv) {
+  int opt, failed = 0;
+
+  while((opt = getopt(argc, argv, "v")) != -1) {
+    switch(opt) {
+      case 'v': gv_verbose = 1; break;
+      default:
+        fprintf(stderr, "Usage: %s [-v]\n", argv[0]);
+        return 2;
+    }
+  }
+
+  gv_start(1); NEC_sendCode(0x04, 0x08);
+  failed += gv_compare("NEC", GV_NEC, GV_LEN(GV_NEC), 38000);
+  gv_start(0); NEC_sendCode(0x1234, 0x56);
+  failed += gv_compare("NEC-ext", GV_NECX, GV_LEN(GV_NECX), 38000);
+  gv_start(0); SAM_sendCode(0x07, 0x02);
+  failed += gv_compare("Samsung", GV_SAM, GV_LEN(GV_SAM), 38000);
+  // RC-5: toggle bit starts at 0 and changes after each key release
+  gv_start(0); RC5_sendCode(0x05, 0x35);
+  failed += gv_compare("RC-5", GV_RC5, GV_LEN(GV_RC5), 36000);
+  gv_start(0); RC5_sendCode(0x05, 0x75);
+  failed += gv_compare("RC-5-ext", GV_RC5X, GV_LEN(GV_RC5X), 36000);
+  gv_start(0); SON_sendCode(0x01, 0x15, 12);
+  failed += gv_compare("SIRC-12", GV_SON12, GV_LEN(GV_SON12), 40000);
+  gv_start(0); SON_sendCode(0xA4, 0x15, 15);
+  failed += gv_compare("SIRC-15", GV_SON15, GV_LEN(GV_SON15), 40000);
+  gv_start(0); SON_sendCode(0x0A3C, 0x15, 20);
+  failed += gv_compare("SIRC-20", GV_SON20, GV_LEN(GV_SON20), 40000);
+
+  printf("F_CPU %d Hz, tolerance %d ticks, mismatches: %d\n", F_CPU, GV_TOL, failed);
+  return failed ? 1 : 0;
+}
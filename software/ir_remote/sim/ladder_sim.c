@@ -0,0 +1,164 @@
+// ===================================================================================
+// Resistor-Ladder Keypad Simulation (Host)
+// ===================================================================================
+//
+// Runs the key decoder of src/ladder.c on ADC values of a simulated ladder with
+// resistor tolerances and ADC errors, for supply voltages from 3.3V down to 2.0V
+// (CR2032 from new to empty). For each key and voltage -m presses are simulated:
+// R0 and the key resistor are drawn within -t %, the ADC reading gets a gain error of
+// up to -g %, an offset of up to -o mV and gaussian noise of -n LSB rms. The offset is
+// an absolute voltage, so its share of the reading grows as VDD drops, everything else
+// is ratiometric. The report lists the misread keys, the smallest distance of a
+// reading to a decision limit and the presses whose level is above the input low level
+// of the pin (-l % of VDD), which wouldn't wake the MCU.
+//
+// Afterwards the scan of the ladder is compared with reading five key pins directly:
+// time per scan at F_CPU (cycle estimates of the compiled code, ADC conversion in fast
+// mode at HCLK/2), charge per scan at the MCU current of -i mA, and the current while
+// a key is held (internal pullup of -r kOhm for direct keys). In standby both draw no
+// current through the keys (all open, ADC off).
+//
+// Build:  make sim  (or: cc -O2 -DLADDER_HOST -I. -Isrc -Isim -o bin/ladder_sim
+//                        sim/ladder_sim.c src/ladder.c -lm)
+// Usage:  bin/ladder_sim [-t tolerance%] [-g gain%] [-o offset mV] [-n noise LSB]
+//                        [-l VIL%] [-m presses] [-r pullup kOhm] [-i mA] [-s seed]
+//
+// The exit status is 1 if any key was misread.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include "ladder.h"
+
+#define LS_ADC_CLOCKS     28                  // ADC clocks of a conversion in fast mode
+#define LS_ADC_DIV        2                   // ADC clock is HCLK / 2
+#define LS_CY_DIRECT      25                  // 5 * (lw, andi, beqz) + return
+#define LS_CY_LADDER      60                  // pin mode twice (rmw CFGLR), ADC on/off,
+                                              // start, poll EOC, read, call
+#define LS_CY_DECODE      6                   // per compared limit (lhu, bltu, addi, j)
+
+static const double ls_R[LADDER_KEYS] = {LADDER_R1, LADDER_R2, LADDER_R3, LADDER_R4,
+                                         LADDER_R5, LADDER_R6, LADDER_R7, LADDER_R8};
+static const double ls_vdd[] = {3.3, 3.0, 2.7, 2.4, 2.2, 2.0};
+#define LS_VDDS           (sizeof(ls_vdd) / sizeof(double))
+
+// Parameters
+static double ls_tol    = 0.01;               // resistor tolerance
+static double ls_gain   = 0.005;              // ADC gain error
+static double ls_offset = 5;                  // ADC offset in mV
+static double ls_noise  = 1;                  // ADC noise in LSB rms
+static double ls_vil    = 0.3;                // input low level of the pin / VDD
+static int    ls_presses = 10000;             // presses per key and voltage
+
+static uint16_t ls_adc;                       // next ADC value
+
+// ===================================================================================
+// Host Backend
+// ===================================================================================
+uint16_t LADDER_HOST_adc(void) {
+  return ls_adc;
+}
+
+// ===================================================================================
+// Ladder Model
+// ===================================================================================
+static double ls_uniform(double range) {
+  return range * (2.0 * rand() / RAND_MAX - 1);
+}
+
+static double ls_gauss(void) {
+  double u = (rand() + 1.0) / (RAND_MAX + 2.0), v = (rand() + 1.0) / (RAND_MAX + 2.0);
+  return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+// Limit of the decoder between key and key + 1 (as in src/ladder.c)
+static double ls_limit(int key) {
+  double level = LADDER_LEVEL(ls_R[key]);
+  if(key < LADDER_KEYS - 1) {
+    return (uint16_t)((level + LADDER_LEVEL(ls_R[key + 1])) / 2);
+  }
+  return (uint16_t)(level + (level - LADDER_LEVEL(ls_R[key - 1])) / 2);
+}
+
+// Simulate presses of all keys at VDD, returns misreads
+static int ls_run(double vdd, int* margin, int* nowake) {
+  int misread = 0;
+  *margin = 1023; *nowake = 0;
+  for(int key=0; key<LADDER_KEYS; key++) {
+    for(int i=0; i<ls_presses; i++) {
+      double r0 = LADDER_R0 * (1 + ls_uniform(ls_tol));
+      double rk = ls_R[key] * (1 + ls_uniform(ls_tol));
+      double ratio = rk / (r0 + rk);
+      double value = 1023 * ratio * (1 + ls_uniform(ls_gain))
+                   + ls_uniform(ls_offset) / (vdd * 1000) * 1023 + ls_noise * ls_gauss();
+      if(value < 0)    value = 0;
+      if(value > 1023) value = 1023;
+      ls_adc = value + 0.5;
+      if(LADDER_read() != key + 1) misread++;
+      int dist = (int)ls_limit(key) - 1 - ls_adc;              // to the upper limit
+      if(key && ls_adc - (int)ls_limit(key - 1) < dist)        // to the lower limit
+        dist = ls_adc - (int)ls_limit(key - 1);
+      if(dist < *margin) *margin = dist;
+      if(ratio >= ls_vil) (*nowake)++;
+    }
+  }
+  ls_adc = 1023;                                               // no key pressed
+  if(LADDER_read() != 0) misread++;
+  return misread;
+}
+
+int main(int argc, char** argv) {
+  int opt, failed = 0;
+  double pullup = 35, current = 1.2;
+  unsigned seed = time(NULL);
+
+  while((opt = getopt(argc, argv, "t:g:o:n:l:m:r:i:s:")) != -1) {
+    switch(opt) {
+      case 't': ls_tol     = atof(optarg) / 100; break;
+      case 'g': ls_gain    = atof(optarg) / 100; break;
+      case 'o': ls_offset  = atof(optarg);       break;
+      case 'n': ls_noise   = atof(optarg);       break;
+      case 'l': ls_vil     = atof(optarg) / 100; break;
+      case 'm': ls_presses = atoi(optarg);       break;
+      case 'r': pullup     = atof(optarg);       break;
+      case 'i': current    = atof(optarg);       break;
+      case 's': seed       = atoi(optarg);       break;
+      default:
+        fprintf(stderr, "Usage: %s [-t tolerance%%] [-g gain%%] [-o offset mV] "
+                        "[-n noise LSB] [-l VIL%%] [-m presses] [-r pullup kOhm] [-i mA] "
+                        "[-s seed]\n", argv[0]);
+        return 2;
+    }
+  }
+  srand(seed);
+
+  printf("Ladder: R0 %d ohms, %d keys, resistors %.1f%%, ADC gain %.1f%%, "
+         "offset %.0f mV, noise %.1f LSB\n", LADDER_R0, LADDER_KEYS, ls_tol * 100,
+         ls_gain * 100, ls_offset, ls_noise);
+  printf("Levels:");
+  for(int k=0; k<LADDER_KEYS; k++) printf(" %4.0f", LADDER_LEVEL(ls_R[k]));
+  printf("\nLimits:");
+  for(int k=0; k<LADDER_KEYS; k++) printf(" %4.0f", ls_limit(k));
+  printf("\n\n%-6s  %10s  %12s  %12s\n", "VDD", "Misread", "Margin/LSB", "No wake");
+  for(unsigned v=0; v<LS_VDDS; v++) {
+    int margin, nowake;
+    int misread = ls_run(ls_vdd[v], &margin, &nowake);
+    printf("%.1fV    %10d  %12d  %12d\n", ls_vdd[v], misread, margin, nowake);
+    failed += misread;
+  }
+  printf("(%d presses per key and voltage)\n", ls_presses);
+
+  double tDirect = LS_CY_DIRECT * 1e6 / F_CPU;
+  double tLadder = (LS_CY_LADDER + LS_ADC_CLOCKS * LS_ADC_DIV
+                 + LADDER_KEYS * LS_CY_DECODE) * 1e6 / F_CPU + LADDER_SETTLE;
+  printf("\n%-12s  %10s  %14s  %18s\n", "Scan", "Time/us", "Charge/nC", "Held at 3V/uA");
+  printf("%-12s  %10.1f  %14.1f  %18.0f\n", "direct pins", tDirect, tDirect * current,
+         3.0 / pullup * 1000);
+  printf("%-12s  %10.1f  %14.1f  %11.0f..%4.0f\n", "ladder", tLadder, tLadder * current,
+         3.0 / (LADDER_R0 + ls_R[LADDER_KEYS - 1]) * 1e6, 3.0 / LADDER_R0 * 1e6);
+  printf("(F_CPU %d Hz, MCU %.1f mA; standby: no current through the keys in both cases)\n",
+         F_CPU, current);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+// ===================================================================================
+// Behavioral Model of an IR Receiver with AGC (Host)
+// ===================================================================================
+
+#include <math.h>
+#include <string.h>
+#include "receiver.h"
+
+const RX_class_t RX_classes[] = {
+  // name    min_burst min_gap max_burst max_rate
+  {"AGC2",   10,       10,        0,        0},   // continuous data, long frames
+  {"AGC3",    6,        6,        0,     2000},   // short bursts
+  {"AGC4",   10,       10,        0,      800},   // typical TV receiver
+  {"AGC5",   10,       12,      400,      500},   // noise robust
+};
+const int RX_count = sizeof(RX_classes) / sizeof(RX_classes[0]);
+
+// Check edges, set flags of each mark (flags[i] for edge i), returns all flags ORed
+uint8_t RX_filter(const RX_class_t* rx, double freq, const DEC_edge_t* e, int n,
+                  uint8_t* flags) {
+  double  T = 1e6 / freq;                     // carrier period in us
+  double  count = 0;                          // leaky burst counter
+  uint8_t all = 0, suppressed = 0;
+  for(int i=0; i<n; i++) {
+    uint8_t f = 0;
+    count *= exp(-e[i].us * 1e-6 / RX_TAU);
+    if(e[i].mark) {
+      count += 1;
+      if(rx->max_rate > 0) {
+        double rate = count / RX_TAU;
+        if(rate > rx->max_rate) suppressed = 1;
+        else if(rate < rx->max_rate * 0.8) suppressed = 0;
+        if(suppressed) f |= RX_RATE;
+      }
+      if(e[i].us < (rx->min_burst - 0.5) * T) f |= RX_SHORT;   // half a period margin
+      if(rx->max_burst > 0 && e[i].us > rx->max_burst * T) f |= RX_LONG;
+      if(i > 0 && !e[i - 1].mark && e[i - 1].us < (rx->min_gap - 0.5) * T) f |= RX_GAP;
+    }
+    if(flags) flags[i] = f;
+    all |= f;
+  }
+  return all;
+}
+
+// Class by name or NULL
+const RX_class_t* RX_find(const char* name) {
+  for(int i=0; i<RX_count; i++) {
+    if(!strcmp(RX_classes[i].name, name)) return &RX_classes[i];
+  }
+  return 0;
+}
+
+// Text of flags
+const char* RX_describe(uint8_t flags) {
+  static char text[32];
+  text[0] = 0;
+  if(!flags)            strcat(text, "ok");
+  if(flags & RX_SHORT)  strcat(text, "short ");
+  if(flags & RX_GAP)    strcat(text, "gap ");
+  if(flags & RX_LONG)   strcat(text, "long ");
+  if(flags & RX_RATE)   strcat(text, "rate ");
+  if(flags) text[strlen(text) - 1] = 0;
+  return text;
+}
@@ -0,0 +1,60 @@
+// ===================================================================================
+// Behavioral Model of an IR Receiver with AGC (Host)
+// ===================================================================================
+//
+// Integrated IR receivers (TSOP style) contain an automatic gain control, which
+// reduces the sensitivity when it sees a signal that looks like interference. A frame
+// with perfect timing can still be cut or suppressed. The model passes the recorded
+// marks and spaces of a transmission through the following rules and flags every mark
+// that the receiver would not put out correctly:
+//
+// RX_SHORT  the mark is shorter than min_burst carrier periods (not detected),
+// RX_GAP    the preceding space is shorter than min_gap carrier periods (the mark
+//           merges with the previous one),
+// RX_LONG   the mark is longer than max_burst carrier periods (taken as continuous
+//           interference, the output drops before the end of the mark),
+// RX_RATE   the AGC is pulled down by a high rate of bursts: the rate is averaged by
+//           a leaky counter with a time constant of RX_TAU, marks are suppressed while
+//           the rate is above max_rate and until it falls below 80% of it.
+//
+// The classes are modelled after the AGC classes of receiver data sheets, from data
+// formats with continuous data (AGC2) and short bursts (AGC3) to typical TV receivers
+// (AGC4) and noise-robust ones (AGC5). The values are rounded behavioral parameters
+// that reproduce the typical limits, not the exact limits of a particular part. A
+// limit of 0 is not checked.
+//
+// Functions available:
+// --------------------
+// RX_filter(class, freq, e, n, flags)  check n edges at carrier freq, set flags of
+//                                      each mark, returns all flags ORed
+// RX_find(name)                        class by name or NULL
+// RX_describe(flags)                   text of flags
+
+#pragma once
+
+#include <stdint.h>
+#include "decoders.h"
+
+#define RX_TAU            0.1                 // time constant of burst rate in s
+
+#define RX_SHORT          0x01
+#define RX_GAP            0x02
+#define RX_LONG           0x04
+#define RX_RATE           0x08
+
+// Receiver class
+typedef struct {
+  const char* name;
+  double min_burst;                           // min mark in carrier periods
+  double min_gap;                             // min space in carrier periods
+  double max_burst;                           // max mark in carrier periods
+  double max_rate;                            // max sustained bursts per second
+} RX_class_t;
+
+extern const RX_class_t RX_classes[];
+extern const int        RX_count;
+
+uint8_t RX_filter(const RX_class_t* rx, double freq, const DEC_edge_t* e, int n,
+                  uint8_t* flags);
+const RX_class_t* RX_find(const char* name);
+const char* RX_describe(uint8_t flags);
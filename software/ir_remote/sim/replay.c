@@ -0,0 +1,324 @@
+// ===================================================================================
+// Replay of Logic Analyzer Captures into the Capture Decoders (Host)
+// ===================================================================================
+//
+// Loads a capture of the output of an IR receiver (CSV or VCD, e.g. exported by
+// Saleae Logic or sigrok/PulseView), converts it into marks and spaces with their
+// true timing and passes them to the decoders of sim/decoders.c. The capture may be
+// noisy and clipped: spikes shorter than the glitch filter are removed, frames that
+// are cut at the start or end of the capture are counted, but can't be decoded.
+//
+// CSV:  one line per sample or transition, "time,value[,value...]", lines that don't
+//       start with a number (headers) are skipped. The time is in seconds (scaled by
+//       -t), -c selects the value column (1 = first value).
+// VCD:  the signal is selected by name with -c, default is the first 1-bit signal.
+//
+// The receiver output is active low (low = carrier detected), use -i for captures of
+// active high signals (e.g. at the IR LED). For each frame (marks and spaces up to a
+// space longer than DEC_GAP) the decoders are tried, the report lists the decoded
+// codes, the frames that couldn't be decoded, the largest timing deviation and the
+// time the decoders needed per edge on the host. With -e the accuracy against an
+// expected code (as printed in the report, e.g. "NEC 0x04 0x08") is calculated. An
+// NEC repeat code counts as a match only if the expected code is an NEC code and the
+// last full frame before it matched.
+//
+// For tests without a logic analyzer, -y writes a synthetic capture (CSV) of one of
+// the encoders (-P NEC, SAM, SAM36, SAM48, RC5, SON, RMM or XMP) with the distortion
+// of a receiver: marks are extended by -x us (spaces shortened accordingly), each edge
+// is shifted by up to -j us, spikes are added with -z % per edge, and the capture
+// starts within the first frame (clipped).
+//
+// Build:  make sim  (or: cc -O2 -DIR_HOST -I. -Isrc -Isim -o bin/replay sim/replay.c
+//                        sim/decoders.c src/protocols.c src/ir.c -lm)
+// Usage:  bin/replay [-c column/signal] [-t scale] [-i] [-g glitch us] [-e code] file
+//         bin/replay -y out.csv [-P protocol] [-r repeats] [-x us] [-j us] [-z %] [-s seed]
+//
+// The exit status is 1 if an expected code was given and not every frame matched it.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include "protocols.h"
+#include "decoders.h"
+
+#define RP_MAX            (1 << 20)           // max number of transitions
+
+// Transitions of the capture
+static double  rp_time[RP_MAX];               // time in us
+static uint8_t rp_level[RP_MAX];              // level after transition
+static int     rp_count;
+
+static void rp_add(double us, uint8_t level) {
+  if(rp_count && rp_level[rp_count - 1] == level) return;  // no change
+  if(rp_count == RP_MAX) return;
+  rp_time[rp_count]  = us;
+  rp_level[rp_count] = level;
+  rp_count++;
+}
+
+// ===================================================================================
+// Capture Files
+// ===================================================================================
+
+// Load CSV, column 1 is the first value after the time
+static int rp_load_csv(FILE* f, int column, double scale) {
+  char line[1024];
+  while(fgets(line, sizeof(line), f)) {
+    char* p = line;
+    while(isspace((unsigned char)*p)) p++;
+    if(!isdigit((unsigned char)*p) && *p != '-' && *p != '.') continue;  // header
+    double t = strtod(p, &p);
+    for(int c=0; c<column && p; c++) {
+      p = strchr(p, ',');
+      if(p) p++;
+    }
+    if(!p) continue;
+    rp_add(t * scale * 1e6, strtol(p, NULL, 0) != 0);
+  }
+  return rp_count ? 0 : -1;
+}
+
+// Load VCD, signal by name (or first 1-bit signal)
+static int rp_load_vcd(FILE* f, const char* name) {
+  char tok[256], id[64] = "", unit[16] = "s";
+  double timescale = 1, t = 0;
+  int defs = 1;
+  while(fscanf(f, "%255s", tok) == 1) {
+    if(defs) {
+      if(!strcmp(tok, "$timescale")) {        // e.g. "1 ns" or "1ns"
+        char num[32] = "";
+        if(fscanf(f, "%31s", num) != 1) return -1;
+        timescale = atof(num);
+        char* u = num;
+        while(*u && (isdigit((unsigned char)*u) || *u == '.')) u++;
+        if(*u) snprintf(unit, sizeof(unit), "%s", u);
+        else if(fscanf(f, "%15s", unit) != 1) return -1;
+        static const char* units[] = {"s", "ms", "us", "ns", "ps", "fs"};
+        for(int i=0; i<6; i++) if(!strcmp(unit, units[i])) timescale *= pow(1e-3, i);
+      }
+      else if(!strcmp(tok, "$var")) {         // $var wire 1 <id> <name> $end
+        char type[32], size[16], vid[64], vname[128];
+        if(fscanf(f, "%31s %15s %63s %127s", type, size, vid, vname) != 4) return -1;
+        if(!strcmp(size, "1") && ((name && !strcmp(vname, name)) || (!name && !id[0])))
+          snprintf(id, sizeof(id), "%s", vid);
+      }
+      else if(!strcmp(tok, "$enddefinitions")) defs = 0;
+      continue;
+    }
+    if(tok[0] == '#') t = atof(tok + 1) * timescale * 1e6;
+    else if((tok[0] == '0' || tok[0] == '1') && !strcmp(tok + 1, id))
+      rp_add(t, tok[0] == '1');
+  }
+  if(!id[0]) fprintf(stderr, "signal not found\n");
+  return rp_count ? 0 : -1;
+}
+
+// ===================================================================================
+// Decoding
+// ===================================================================================
+
+// Convert transitions into marks and spaces, remove spikes shorter than glitch us
+static void rp_edges(uint8_t active, double glitch) {
+  DEC_clear();
+  for(int i=0; i+1<rp_count; i++) {
+    double us = rp_time[i + 1] - rp_time[i];
+    uint8_t mark = rp_level[i] == active;
+    if(us < glitch && DEC_count) {            // spike: add to the previous edge
+      DEC_edges[DEC_count - 1].us += us;
+      continue;
+    }
+    DEC_record(mark, us);
+  }
+}
+
+// Try all decoders at edge i, print code into text, returns edges used or 0
+static int rp_decode(int i, char* text, size_t len, double* err) {
+  const DEC_edge_t* e = DEC_edges + i;
+  int n = DEC_count - i, used;
+  uint32_t d32; uint16_t a16, c16; uint8_t a8, c8, b8, s8, t8, r8;
+  if((used = DEC_NEC(e, n, &a16, &c8, &r8, err))) {
+    if(r8) snprintf(text, len, "NEC repeat");
+    else   snprintf(text, len, "NEC 0x%02X 0x%02X", a16, c8);
+  }
+  else if((used = DEC_SAM(e, n, &a8, &c8, err)))
+    snprintf(text, len, "SAM 0x%02X 0x%02X", a8, c8);
+  else if((used = DEC_SAM36(e, n, &a16, &c16, err)))
+    snprintf(text, len, "SAM36 0x%04X 0x%03X", a16, c16);
+  else if((used = DEC_SAM48(e, n, &a16, &c16, err)))
+    snprintf(text, len, "SAM48 0x%04X 0x%04X", a16, c16);
+  else if((used = DEC_RMM(e, n, &d32, &b8, err)))
+    snprintf(text, len, "RMM 0x%X %d", d32, b8);
+  else if((used = DEC_XMP(e, n, &a8, &b8, &s8, &c16, &t8, err)))
+    snprintf(text, len, "XMP 0x%02X 0x%02X 0x%02X 0x%04X", a8, b8, s8, c16);
+  else if((used = DEC_RC5(e, n, &a8, &c8, &t8, err)))
+    snprintf(text, len, "RC5 0x%02X 0x%02X", a8, c8);
+  else if((used = DEC_SON(e, n, &a16, &c8, &b8, err)))
+    snprintf(text, len, "SON 0x%02X 0x%02X %d", a16, c8, b8);
+  return used;
+}
+
+// Decode all frames, print report, returns 1 if expected code didn't always match
+static int rp_report(const char* expect) {
+  char text[64], codes[64][64];
+  int counts[64], ncodes = 0, frames = 0, failed = 0, matched = 0, last = 0;
+  double maxerr = 0, err;
+  struct timespec t0, t1;
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  for(int i=0; i<DEC_count; ) {
+    if(!DEC_edges[i].mark) { i++; continue; }
+    int used = rp_decode(i, text, sizeof(text), &err);
+    frames++;
+    if(!used) {                               // skip to the end of the frame
+      failed++;
+      last = 0;                               // repeats after it can't be assigned
+      while(i < DEC_count && (DEC_edges[i].mark || DEC_edges[i].us <= DEC_GAP)) i++;
+      continue;
+    }
+    if(err > maxerr) maxerr = err;
+    if(expect) {
+      if(strcmp(text, "NEC repeat")) last = !strcmp(text, expect);  // full frame
+      else last &= !strncmp(expect, "NEC ", 4);  // repeat of the last full frame
+      matched += last;
+    }
+    int k;
+    for(k=0; k<ncodes && strcmp(codes[k], text); k++);
+    if(k == ncodes && ncodes < 64) {
+      snprintf(codes[ncodes], sizeof(codes[0]), "%s", text);
+      counts[ncodes++] = 0;
+    }
+    if(k < 64) counts[k]++;
+    i += used;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+
+  double ns = (t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec);
+  printf("%d transitions, %d edges, %d frames\n", rp_count, DEC_count, frames);
+  for(int k=0; k<ncodes; k++) printf("  %5d x %s\n", counts[k], codes[k]);
+  printf("not decoded: %d frames (%.1f%%)\n", failed, frames ? 100.0 * failed / frames : 0);
+  printf("max deviation of decoded edges: %.1f us\n", maxerr);
+  printf("decoder time: %.0f ns per edge (host)\n", DEC_count ? ns / DEC_count : 0);
+  if(!expect) return 0;
+  printf("accuracy for \"%s\": %d of %d frames (%.1f%%)\n", expect, matched, frames,
+         frames ? 100.0 * matched / frames : 0);
+  return matched != frames;
+}
+
+// ===================================================================================
+// Synthetic Captures
+// ===================================================================================
+static FILE*  sy_file;
+static double sy_time, sy_extend, sy_jitter, sy_spikes, sy_start;
+static int    sy_repeats, sy_level;
+
+static double sy_random(void) {
+  return (double)rand() / ((double)RAND_MAX + 1);
+}
+
+// Write transition at time t (us) with receiver output level (active low)
+static void sy_write(double t, uint8_t mark) {
+  if(t < sy_start) return;                    // clipped start
+  fprintf(sy_file, "%.9f,%d\n", (t - sy_start) * 1e-6, !mark);
+}
+
+void IR_HOST_carrier(uint32_t freq) {
+  (void)freq;
+}
+
+void IR_HOST_edge(uint8_t mark, uint32_t ticks) {
+  if(mark != sy_level) {                      // transition
+    double t = sy_time + (mark ? 0 : sy_extend) + (sy_random() * 2 - 1) * sy_jitter;
+    sy_write(t, mark);
+    sy_level = mark;
+    if(sy_random() < sy_spikes) {             // spike of 2..12us after the edge
+      double s = t + 20 + sy_random() * 40;
+      sy_write(s, !mark);
+      sy_write(s + 2 + sy_random() * 10, mark);
+    }
+  }
+  sy_time += ticks * 1000000.0 / F_CPU;
+}
+
+uint8_t KEY_read(void) {
+  return sy_repeats-- > 0;
+}
+
+static int rp_synth(const char* file, const char* proto) {
+  sy_file = fopen(file, "w");
+  if(!sy_file) { perror(file); return 2; }
+  fprintf(sy_file, "Time [s],IR\n");
+  sy_start = sy_random() * 2000;              // clip the first frame
+  sy_write(sy_start, 0);
+  if     (!strcmp(proto, "NEC"))   NEC_sendCode(0x04, 0x08);
+  else if(!strcmp(proto, "SAM"))   SAM_sendCode(0x07, 0x02);
+  else if(!strcmp(proto, "SAM36")) SAM36_sendCode(0x0707, 0x102);
+  else if(!strcmp(proto, "SAM48")) SAM48_sendCode(0x0707, 0xA1B2);
+  else if(!strcmp(proto, "RC5"))   RC5_sendCode(0x00, 0x0B);
+  else if(!strcmp(proto, "SON"))   SON_sendCode(0x01, 0x15, 12);
+  else if(!strcmp(proto, "RMM"))   RMM_sendCode(0x123456, 24);
+  else if(!strcmp(proto, "XMP"))   XMP_sendCode(0x44, 0x12, 0x03, 0x1234);
+  else {
+    fprintf(stderr, "unknown protocol %s\n", proto);
+    return 2;
+  }
+  IR_HOST_edge(0, F_CPU / 100);               // 10ms idle at the end
+  sy_write(sy_time, 0);
+  fclose(sy_file);
+  return 0;
+}
+
+// ===================================================================================
+// Main
+// ===================================================================================
+int main(int argc, char** argv) {
+  int opt, invert = 0;
+  const char *column = NULL, *expect = NULL, *synth = NULL, *proto = "NEC";
+  double scale = 1, glitch = 50;
+  unsigned seed = time(NULL);
+
+  sy_repeats = 3; sy_extend = 40; sy_jitter = 10; sy_spikes = 0;
+  while((opt = getopt(argc, argv, "c:t:ig:e:y:P:r:x:j:z:s:")) != -1) {
+    switch(opt) {
+      case 'c': column     = optarg;                break;
+      case 't': scale      = atof(optarg);          break;
+      case 'i': invert     = 1;                     break;
+      case 'g': glitch     = atof(optarg);          break;
+      case 'e': expect     = optarg;                break;
+      case 'y': synth      = optarg;                break;
+      case 'P': proto      = optarg;                break;
+      case 'r': sy_repeats = atoi(optarg);          break;
+      case 'x': sy_extend  = atof(optarg);          break;
+      case 'j': sy_jitter  = atof(optarg);          break;
+      case 'z': sy_spikes  = atof(optarg) / 100;    break;
+      case 's': seed       = atoi(optarg);          break;
+      default:
+        fprintf(stderr, "Usage: %s [-c column/signal] [-t scale] [-i] [-g glitch us] "
+                "[-e code] file\n       %s -y out.csv [-P protocol] [-r repeats] "
+                "[-x us] [-j us] [-z %%] [-s seed]\n", argv[0], argv[0]);
+        return 2;
+    }
+  }
+  srand(seed);
+  if(synth) return rp_synth(synth, proto);
+  if(optind >= argc) {
+    fprintf(stderr, "no capture file\n");
+    return 2;
+  }
+
+  FILE* f = fopen(argv[optind], "r");
+  if(!f) { perror(argv[optind]); return 2; }
+  const char* ext = strrchr(argv[optind], '.');
+  int res = (ext && !strcmp(ext, ".vcd")) ? rp_load_vcd(f, column)
+                                          : rp_load_csv(f, column ? atoi(column) : 1, scale);
+  fclose(f);
+  if(res) {
+    fprintf(stderr, "%s: no transitions found\n", argv[optind]);
+    return 2;
+  }
+  rp_edges(invert, glitch);
+  return rp_report(expect);
+}
@@ -0,0 +1,388 @@
+// ===================================================================================
+// Room-Scale Multi-Device Collision Simulation (Host)
+// ===================================================================================
+//
+// Places a number of remotes and receivers in a shared IR channel and simulates the
+// key presses of the users for a given time. The transmissions are recorded from the
+// encoders of src/protocols.c by the IR_HOST backend, so they have the real timings,
+// repeat frames and pauses of the firmware. KEY_read() of the encoders is answered by
+// the press model: a key is held for an exponentially distributed time, the presses
+// of each remote arrive as a Poisson process.
+//
+// A press that arrives while the remote is still sending starts after the previous
+// one. A frame is lost at a receiver if a mark of any other remote that can be seen by
+// this receiver overlaps the frame (from its first mark to the end of its last mark).
+// A key press is missed if none of its frames carrying data (NEC repeat codes carry
+// none) arrives at the target receiver. Each remote can be seen by its own receiver,
+// by the other receivers and by the other remotes with the given probability.
+//
+// Repeat policy and listen-before-talk can be tuned:
+// - every press sends at least -m frames, even if the key is released earlier,
+// - before the first frame a remote listens for -L us and only starts if it hasn't
+//   seen a mark, otherwise it backs off for a random time up to -B us and listens
+//   again (at most 8 times, then it sends anyway).
+// With -a, every frame is also passed through the receiver model of sim/receiver.c
+// (AGC class AGC2 to AGC5). Frames with marks that the receiver would cut or suppress
+// are lost as well, they are counted separately.
+// The energy of each press is the time the remote is awake (listening and sending)
+// at the given average current (-i mA, 5mA measured for an NEC telegram) and 3V.
+//
+// Independent scenarios (one room each, with its own random seed) are distributed to
+// worker processes on all cores.
+//
+// Build:  make sim  (or: cc -O2 -DIR_HOST -I. -Isrc -Isim -o bin/room_sim sim/room_sim.c
+//                        sim/receiver.c src/protocols.c src/ir.c -lm)
+// Usage:  bin/room_sim [-r remotes] [-d receivers] [-p visibility%] [-t seconds]
+//                      [-k presses/min] [-h hold ms] [-m min frames] [-L listen us]
+//                      [-B backoff us] [-a AGC class] [-i mA] [-n scenarios] [-j jobs]
+//                      [-s seed]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "protocols.h"
+#include "receiver.h"
+
+#define SIM_HOLD_MAX      2000000.0           // max hold time in us
+#define SIM_DATA_MARKS    8                   // frames with less marks carry no data
+#define SIM_BACKOFFS      8                   // max number of backoffs per press
+#define SIM_VOLTAGE       3.0                 // supply voltage
+
+// Parameters
+static int    sim_remotes   = 8;              // number of remotes
+static int    sim_receivers = 4;              // number of receivers
+static double sim_visible   = 1.0;            // probability to see another remote
+static double sim_time      = 60e6;           // simulated time per scenario in us
+static double sim_rate      = 6;              // presses per minute and remote
+static double sim_hold      = 150e3;          // mean hold time in us
+static int    sim_min       = 1;              // min number of frames per press
+static double sim_listen    = 0;              // listen-before-talk window in us
+static double sim_backoff   = 20e3;           // max random backoff in us
+static double sim_current   = 5;              // average current while awake in mA
+static const RX_class_t* sim_agc;             // receiver model or NULL
+
+// Frame of a transmission
+typedef struct {
+  int     first, last;                        // index of first and last mark
+  uint8_t data;                               // carries data (not a repeat code)
+  uint8_t agc;                                // receiver flags of the frame's marks
+} sim_frame_t;
+
+// Transmission of one key press
+typedef struct {
+  int          remote;
+  double       request;                       // time of key press
+  double       start;                         // time of first edge
+  double       length;                        // time until end of last edge
+  double       awake;                         // listening time before start
+  uint32_t     freq;                          // carrier frequency
+  int          nmarks, nframes, backoffs;
+  double*      mark;                          // start, end of each mark (relative)
+  sim_frame_t* frame;
+} sim_tx_t;
+
+// Results of a scenario, summed up over all scenarios
+typedef struct {
+  unsigned long presses, missed;
+  unsigned long frames, lost;                 // frames with data at target receiver
+  unsigned long suppressed;                   // frames with data cut by the AGC
+  unsigned long backoffs, forced;             // LBT backoffs, presses sent anyway
+  double        charge;                       // in mAs
+} sim_result_t;
+
+// ===================================================================================
+// Recording of the Firmware's Transmissions
+// ===================================================================================
+static sim_tx_t* rec_tx;                      // transmission being recorded
+static double    rec_time;                    // current time in us
+static double    rec_hold;                    // hold time of the key
+static int       rec_level, rec_capacity, rec_frames, rec_first;
+
+static void rec_close_frame(void) {
+  sim_tx_t* tx = rec_tx;
+  if(tx->nmarks == rec_first) return;         // no marks since last frame
+  tx->frame = realloc(tx->frame, (tx->nframes + 1) * sizeof(sim_frame_t));
+  tx->frame[tx->nframes].first = rec_first;
+  tx->frame[tx->nframes].last  = tx->nmarks - 1;
+  tx->frame[tx->nframes].data  = tx->nmarks - rec_first >= SIM_DATA_MARKS;
+  tx->frame[tx->nframes].agc   = 0;
+  tx->nframes++;
+  rec_first = tx->nmarks;
+}
+
+void IR_HOST_carrier(uint32_t freq) {
+  rec_tx->freq = freq;
+}
+
+void IR_HOST_edge(uint8_t mark, uint32_t ticks) {
+  sim_tx_t* tx = rec_tx;
+  double us = ticks * 1000000.0 / F_CPU;
+  if(mark && !rec_level) {                    // new mark
+    if(tx->nmarks == rec_capacity) {
+      rec_capacity = rec_capacity ? rec_capacity * 2 : 256;
+      tx->mark = realloc(tx->mark, rec_capacity * 2 * sizeof(double));
+    }
+    tx->mark[tx->nmarks * 2]     = rec_time;
+    tx->mark[tx->nmarks * 2 + 1] = rec_time;
+    tx->nmarks++;
+  }
+  rec_time += us;
+  if(mark) tx->mark[tx->nmarks * 2 - 1] = rec_time;
+  rec_level = mark;
+}
+
+// Press model: the encoders ask after each frame whether the key is still down
+uint8_t KEY_read(void) {
+  rec_close_frame();
+  rec_frames++;
+  return rec_frames < sim_min || rec_time < rec_hold;
+}
+
+// Pass the marks through the receiver model, flag the frames
+static void rec_agc(sim_tx_t* tx) {
+  DEC_edge_t* e = malloc(tx->nmarks * 2 * sizeof(DEC_edge_t));
+  uint8_t* flags = malloc(tx->nmarks * 2);
+  double end = 0;
+  int n = 0;
+  for(int i=0; i<tx->nmarks; i++) {           // spaces before the marks, then marks
+    if(i) {
+      e[n].mark = 0; e[n].us = tx->mark[i * 2] - end;
+      n++;
+    }
+    e[n].mark = 1; e[n].us = tx->mark[i * 2 + 1] - tx->mark[i * 2];
+    end = tx->mark[i * 2 + 1];
+    n++;
+  }
+  RX_filter(sim_agc, tx->freq, e, n, flags);
+  for(int f=0; f<tx->nframes; f++) {          // mark i is edge 2 * i
+    for(int i=tx->frame[f].first; i<=tx->frame[f].last; i++) {
+      tx->frame[f].agc |= flags[i * 2];
+    }
+  }
+  free(e);
+  free(flags);
+}
+
+// Record the transmission of a key press with the remote's code
+static void rec_press(sim_tx_t* tx, int remote, double hold) {
+  static const int codes = 7;
+  uint32_t r = (uint32_t)remote * 2654435761u;  // fixed code per remote
+  memset(tx, 0, sizeof(*tx));
+  tx->remote = remote;
+  rec_tx = tx;
+  rec_time = 0; rec_hold = hold;
+  rec_level = 0; rec_capacity = 0; rec_frames = 0; rec_first = 0;
+  switch(remote % codes) {
+    case 0: NEC_sendCode(r & 0xff, r >> 8);                  break;
+    case 1: SAM_sendCode(r & 0xff, r >> 8);                  break;
+    case 2: RC5_sendCode(r & 0x1f, r >> 8);                  break;
+    case 3: SON_sendCode(r & 0x1f, r >> 8, 12);              break;
+    case 4: RMM_sendCode(r, 24);                             break;
+    case 5: XMP_sendCode(r, r >> 8, r >> 16, r >> 4);        break;
+    case 6: SAM48_sendCode(r, r >> 16);                      break;
+  }
+  rec_close_frame();
+  tx->length = rec_time;
+  if(sim_agc) rec_agc(tx);
+}
+
+// ===================================================================================
+// Scenario
+// ===================================================================================
+
+// Exponentially distributed random number with the given mean
+static double sim_exp(double mean) {
+  return -log(1.0 - drand48()) * mean;
+}
+
+// Does tx have a mark within [from, to) (absolute times)?
+static int sim_busy(const sim_tx_t* tx, double from, double to) {
+  if(tx->start >= to || tx->start + tx->length <= from) return 0;
+  for(int i=0; i<tx->nmarks; i++) {
+    double s = tx->start + tx->mark[i * 2], e = tx->start + tx->mark[i * 2 + 1];
+    if(s >= to) return 0;
+    if(e > from) return 1;
+  }
+  return 0;
+}
+
+// Run one scenario, add results
+static void sim_scenario(unsigned seed, sim_result_t* res) {
+  int R = sim_remotes, D = sim_receivers;
+  uint8_t  see[R][R + D];                     // remote is seen by remote/receiver
+  sim_tx_t* tx = NULL;
+  int n = 0, placed = 0;
+
+  srand48(seed);
+  for(int a=0; a<R; a++) {
+    for(int b=0; b<R + D; b++) see[a][b] = drand48() < sim_visible;
+    see[a][R + a % D] = 1;                    // own receiver always sees the remote
+  }
+
+  // Key presses of all remotes
+  for(int a=0; a<R; a++) {
+    for(double t=sim_exp(60e6 / sim_rate); t<sim_time; t+=sim_exp(60e6 / sim_rate)) {
+      double hold = sim_exp(sim_hold);
+      tx = realloc(tx, (n + 1) * sizeof(sim_tx_t));
+      rec_press(&tx[n], a, hold < SIM_HOLD_MAX ? hold : SIM_HOLD_MAX);
+      tx[n].request = tx[n].start = t;
+      n++;
+    }
+  }
+
+  // Place transmissions in order of their (possibly deferred) start
+  while(placed < n) {
+    int i = placed;
+    for(int j=placed+1; j<n; j++) if(tx[j].start < tx[i].start) i = j;
+    sim_tx_t t = tx[i];
+    int busy = 0, own = 0;
+    for(int j=0; j<placed; j++) {             // remote is still sending the last press
+      if(tx[j].remote == t.remote && tx[j].start + tx[j].length > t.start) {
+        tx[i].start = tx[j].start + tx[j].length;
+        own = 1;
+      }
+    }
+    if(own) continue;
+    if(sim_listen > 0 && t.backoffs < SIM_BACKOFFS) {
+      for(int j=0; j<placed && !busy; j++) {
+        if(see[tx[j].remote][t.remote] && tx[j].remote != t.remote)
+          busy = sim_busy(&tx[j], t.start - sim_listen, t.start);
+      }
+    }
+    if(busy) {                                // back off and listen again
+      tx[i].start += drand48() * sim_backoff + sim_listen;
+      tx[i].backoffs++;
+      continue;
+    }
+    if(sim_listen > 0 && t.backoffs == SIM_BACKOFFS) res->forced++;
+    t.awake = t.start - t.request + (sim_listen > 0 ? sim_listen : 0);
+    tx[i] = tx[placed];
+    tx[placed++] = t;
+  }
+
+  // Check the frames at the target receivers
+  for(int i=0; i<n; i++) {
+    int rx = R + tx[i].remote % D, ok = 0;
+    for(int f=0; f<tx[i].nframes; f++) {
+      sim_frame_t* fr = &tx[i].frame[f];
+      if(!fr->data) continue;
+      double from = tx[i].start + tx[i].mark[fr->first * 2];
+      double to   = tx[i].start + tx[i].mark[fr->last * 2 + 1];
+      int lost = 0;
+      for(int j=0; j<n && !lost; j++) {
+        if(j != i && see[tx[j].remote][rx]) lost = sim_busy(&tx[j], from, to);
+      }
+      res->frames++;
+      if(lost)         res->lost++;
+      else if(fr->agc) res->suppressed++;
+      else             ok = 1;
+    }
+    res->presses++;
+    if(!ok) res->missed++;
+    res->backoffs += tx[i].backoffs;
+    res->charge   += (tx[i].awake + tx[i].length) * 1e-6 * sim_current;
+  }
+
+  for(int i=0; i<n; i++) {
+    free(tx[i].mark);
+    free(tx[i].frame);
+  }
+  free(tx);
+}
+
+// ===================================================================================
+// Workers
+// ===================================================================================
+int main(int argc, char** argv) {
+  int opt, scenarios = 64, jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  unsigned seed = time(NULL);
+  sim_result_t total = {0};
+
+  while((opt = getopt(argc, argv, "r:d:p:t:k:h:m:L:B:a:i:n:j:s:")) != -1) {
+    switch(opt) {
+      case 'r': sim_remotes   = atoi(optarg);         break;
+      case 'd': sim_receivers = atoi(optarg);         break;
+      case 'p': sim_visible   = atof(optarg) / 100;   break;
+      case 't': sim_time      = atof(optarg) * 1e6;   break;
+      case 'k': sim_rate      = atof(optarg);         break;
+      case 'h': sim_hold      = atof(optarg) * 1e3;   break;
+      case 'm': sim_min       = atoi(optarg);         break;
+      case 'L': sim_listen    = atof(optarg);         break;
+      case 'B': sim_backoff   = atof(optarg);         break;
+      case 'a': sim_agc       = RX_find(optarg);
+                if(!sim_agc) {
+                  fprintf(stderr, "unknown AGC class %s\n", optarg);
+                  return 2;
+                }
+                break;
+      case 'i': sim_current   = atof(optarg);         break;
+      case 'n': scenarios     = atoi(optarg);         break;
+      case 'j': jobs          = atoi(optarg);         break;
+      case 's': seed          = atoi(optarg);         break;
+      default:
+        fprintf(stderr, "Usage: %s [-r remotes] [-d receivers] [-p visibility%%] "
+                "[-t seconds] [-k presses/min] [-h hold ms] [-m min frames] "
+                "[-L listen us] [-B backoff us] [-a AGC class] [-i mA] [-n scenarios] "
+                "[-j jobs] [-s seed]\n", argv[0]);
+        return 2;
+    }
+  }
+  if(sim_remotes < 1 || sim_receivers < 1 || sim_rate <= 0 || scenarios < 1) {
+    fprintf(stderr, "remotes, receivers, press rate and scenarios must be positive\n");
+    return 2;
+  }
+  if(jobs < 1) jobs = 1;
+  if(jobs > scenarios) jobs = scenarios;
+
+  // Each worker runs every jobs-th scenario and passes its sums through a pipe
+  int   fd[jobs];
+  pid_t pid[jobs];
+  for(int w=0; w<jobs; w++) {
+    int p[2];
+    if(pipe(p)) return 1;
+    pid[w] = fork();
+    if(pid[w] < 0) return 1;
+    if(!pid[w]) {
+      sim_result_t res = {0};
+      close(p[0]);
+      for(int s=w; s<scenarios; s+=jobs) sim_scenario(seed + s, &res);
+      if(write(p[1], &res, sizeof(res)) != sizeof(res)) exit(1);
+      exit(0);
+    }
+    close(p[1]);
+    fd[w] = p[0];
+  }
+  for(int w=0; w<jobs; w++) {
+    sim_result_t res;
+    if(read(fd[w], &res, sizeof(res)) != sizeof(res)) return 1;
+    close(fd[w]);
+    waitpid(pid[w], NULL, 0);
+    total.presses  += res.presses;  total.missed += res.missed;
+    total.frames   += res.frames;   total.lost   += res.lost;
+    total.suppressed += res.suppressed;
+    total.backoffs += res.backoffs; total.forced += res.forced;
+    total.charge   += res.charge;
+  }
+
+  printf("%d scenarios of %.0f s on %d jobs, seed %u\n", scenarios, sim_time / 1e6, jobs, seed);
+  printf("%d remotes, %d receivers, visibility %.0f%%, %.1f presses/min, hold %.0f ms\n",
+         sim_remotes, sim_receivers, sim_visible * 100, sim_rate, sim_hold / 1e3);
+  printf("policy: min %d frames, listen %.0f us, backoff %.0f us\n",
+         sim_min, sim_listen, sim_backoff);
+  printf("presses: %lu, missed: %lu (%.2f%%)\n", total.presses, total.missed,
+         total.presses ? 100.0 * total.missed / total.presses : 0);
+  printf("data frames: %lu, lost by collision: %lu (%.2f%%)\n", total.frames, total.lost,
+         total.frames ? 100.0 * total.lost / total.frames : 0);
+  if(sim_agc) printf("suppressed by %s receivers: %lu (%.2f%%)\n", sim_agc->name,
+                     total.suppressed,
+                     total.frames ? 100.0 * total.suppressed / total.frames : 0);
+  printf("LBT backoffs: %lu, sent anyway: %lu\n", total.backoffs, total.forced);
+  printf("energy: %.3f mJ per press (%.1f mA awake at %.0f V)\n",
+         total.presses ? total.charge * SIM_VOLTAGE / total.presses : 0,
+         sim_current, SIM_VOLTAGE);
+  return 0;
+}
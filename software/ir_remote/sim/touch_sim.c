@@ -0,0 +1,231 @@
+// ===================================================================================
+// Simulation of Capacitive Touch Keys with AWU Scanning (Host)
+// ===================================================================================
+//
+// Runs TOUCH_init() and TOUCH_read() of src/touch.c on a model of the pads, in the way
+// the main loop calls them: the AWU wakes the MCU after the period set by the touch
+// code, after the wake-up time from standby TOUCH_read() scans the pads. If it returns
+// a key, the key is "sent" by calling TOUCH_read() again after each frame (-r ms)
+// until it returns 0, as the encoders do by KEY_read().
+//
+// Pad model: each pad has a capacitance of -c pF (+/-10% between the pads), which
+// drifts by up to -d pF with a period of -D s (temperature, humidity). A finger adds
+// -f pF, ramping up within 30ms after the touch starts and ending at once. Touches
+// arrive as a Poisson process (-k per minute) on a random pad and last -h ms on
+// average (exponentially distributed, at least 50ms). A reading is the charge level
+// 1023 * (1 - exp(-t / (TOUCH_R * C))) at the sample time t (-a us after releasing the
+// pad) plus gaussian noise of -n LSB rms.
+//
+// A touch is detected if TOUCH_read() returns its key while the finger is on the
+// pad, the latency is the time from the start of the touch. Touches that end before
+// they are detected are missed, keys returned without finger (or the wrong key) are
+// false. The energy per scan cycle is the charge of the MCU (-i mA) during the
+// wake-up and the scan times VDD (-V), the scan time is a cycle estimate of the
+// compiled code (ADC in fast mode at HCLK/2). The average current is the standby
+// current (9uA) plus the charge of all scan cycles, the IR transmission not included.
+// With -v, the debug output of src/touch.c (src/debug.c) is shown on stderr.
+//
+// Build:  make sim  (or: cc -O2 -DTOUCH_HOST -DDBG_HOST -I. -Isrc -Isim
+//                        -o bin/touch_sim sim/touch_sim.c src/touch.c src/debug.c
+//                        sim/debugger.c -lm)
+// Usage:  bin/touch_sim [-c pad pF] [-f finger pF] [-a sample us] [-n noise LSB]
+//                       [-d drift pF] [-D drift s] [-k touches/min] [-h hold ms]
+//                       [-r frame ms] [-i mA] [-V volts] [-t seconds] [-s seed] [-v]
+//
+// The exit status is 1 if any key was false. Touches shorter than the slow period
+// can be missed, they are counted only.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include "touch.h"
+#include "debug.h"
+#include "debugger.h"
+
+#define SIM_STANDBY       0.009               // standby current in mA
+#define SIM_WAKEUP        200.0               // wake-up time from standby in us
+#define SIM_RAMP          30000.0             // finger approach in us
+#define SIM_MINHOLD       80000.0             // shortest touch in us
+#define SIM_ADC_CLOCKS    28                  // ADC clocks of a conversion in fast mode
+#define SIM_ADC_DIV       2                   // ADC clock is HCLK / 2
+#define SIM_CY_SAMPLE     14                  // pin mode twice (rmw CFGLR), start, poll,
+                                              // read, add
+#define SIM_CY_PAD        8                   // ADC_input, loop setup, store
+#define SIM_CY_UPDATE     40                  // TOUCH_update() per pad
+#define SIM_CY_READ       30                  // TOUCH_read() without scan
+
+// Parameters
+static double sim_pad    = 10;                // pad capacitance in pF
+static double sim_finger = 2;                 // finger capacitance in pF
+static double sim_sample = 5.3;               // sample time after release in us
+static double sim_noise  = 2;                 // ADC noise in LSB rms
+static double sim_drift  = 1;                 // drift amplitude in pF
+static double sim_dperiod = 600e6;            // drift period in us
+static double sim_rate   = 6;                 // touches per minute
+static double sim_hold   = 300e3;             // mean touch time in us
+static double sim_frame  = 108e3;             // IR frame time in us
+static double sim_time   = 3600e6;            // simulated time in us
+
+// State
+static double sim_now;                        // current time in us
+static double sim_period;                     // AWU period in us
+static double sim_c[TOUCH_KEYS];              // pad capacitances without drift
+static double sim_phase[TOUCH_KEYS];          // drift phases
+static int    sim_key   = -1;                 // touched pad or -1
+static double sim_start, sim_end;             // current touch
+
+// ===================================================================================
+// Host Backend
+// ===================================================================================
+
+// Capacitance of pad key at the current time in pF
+static double sim_cap(uint8_t key) {
+  double c = sim_c[key]
+           + sim_drift * sin(2 * M_PI * sim_now / sim_dperiod + sim_phase[key]);
+  if(key == sim_key && sim_now >= sim_start && sim_now < sim_end) {
+    c += sim_finger * fmin(1, (sim_now - sim_start) / SIM_RAMP);
+  }
+  return c;
+}
+
+static double sim_gauss(void) {
+  return sqrt(-2 * log(1.0 - drand48())) * cos(2 * M_PI * drand48());
+}
+
+uint16_t TOUCH_HOST_measure(uint8_t key) {
+  double v = 1023 * (1 - exp(-sim_sample / (TOUCH_R * sim_cap(key) * 1e-6)))
+           + sim_noise * sim_gauss();
+  if(v < 0)    v = 0;
+  if(v > 1023) v = 1023;
+  return (uint16_t)(v + 0.5);
+}
+
+void TOUCH_HOST_period(uint16_t ms) {
+  sim_period = ms * 1000.0;
+}
+
+// ===================================================================================
+// Simulation
+// ===================================================================================
+
+// Exponentially distributed random number with the given mean
+static double sim_exp(double mean) {
+  return -log(1.0 - drand48()) * mean;
+}
+
+int main(int argc, char** argv) {
+  int opt;
+  double mcu = 1.2, vdd = 3.0;
+  long seed = time(NULL);
+
+  while((opt = getopt(argc, argv, "c:f:a:n:d:D:k:h:r:i:V:t:s:v")) != -1) {
+    switch(opt) {
+      case 'c': sim_pad     = atof(optarg);       break;
+      case 'f': sim_finger  = atof(optarg);       break;
+      case 'a': sim_sample  = atof(optarg);       break;
+      case 'n': sim_noise   = atof(optarg);       break;
+      case 'd': sim_drift   = atof(optarg);       break;
+      case 'D': sim_dperiod = atof(optarg) * 1e6; break;
+      case 'k': sim_rate    = atof(optarg);       break;
+      case 'h': sim_hold    = atof(optarg) * 1e3; break;
+      case 'r': sim_frame   = atof(optarg) * 1e3; break;
+      case 'i': mcu         = atof(optarg);       break;
+      case 'V': vdd         = atof(optarg);       break;
+      case 't': sim_time    = atof(optarg) * 1e6; break;
+      case 's': seed        = atol(optarg);       break;
+      case 'v': DBG_HOST_attached = 1;            break;
+      default:
+        fprintf(stderr, "Usage: %s [-c pad pF] [-f finger pF] [-a sample us] "
+                        "[-n noise LSB] [-d drift pF] [-D drift s] [-k touches/min] "
+                        "[-h hold ms] [-r frame ms] [-i mA] [-V volts] [-t seconds] "
+                        "[-s seed] [-v]\n", argv[0]);
+        return 2;
+    }
+  }
+  srand48(seed);
+
+  // Scan time and charge per scan cycle
+  double tSample = (SIM_CY_SAMPLE + SIM_ADC_CLOCKS * SIM_ADC_DIV) * 1e6 / F_CPU;
+  double tScan   = TOUCH_SETTLE + (TOUCH_KEYS * (TOUCH_SAMPLES * (SIM_CY_SAMPLE
+                 + SIM_ADC_CLOCKS * SIM_ADC_DIV) + SIM_CY_PAD + SIM_CY_UPDATE)
+                 + SIM_CY_READ) * 1e6 / F_CPU;
+  double qCycle  = mcu * (SIM_WAKEUP + tScan) * 1e-3;              // in uC
+
+  for(int k=0; k<TOUCH_KEYS; k++) {
+    sim_c[k]     = sim_pad * (1 + 0.1 * (2 * drand48() - 1));
+    sim_phase[k] = 2 * M_PI * drand48();
+  }
+  TOUCH_init();
+
+  // Touches and AWU cycles
+  long touches = 0, detected = 0, missed = 0, falses = 0, wrong = 0;
+  long slow = 0, fast = 0;
+  double latSum = 0, latMax = 0, tScans = 0;
+  int hit = 0;
+  sim_start = sim_exp(60e6 / sim_rate);
+  sim_end   = sim_start + SIM_MINHOLD + sim_exp(sim_hold);
+  sim_key   = lrand48() % TOUCH_KEYS;
+  while(sim_now < sim_time) {
+    if(sim_period > TOUCH_FAST * 1000.0) slow++;
+    else fast++;
+    sim_now += sim_period + SIM_WAKEUP;
+    if(sim_now >= sim_end) {                  // touch over: next one
+      touches++;
+      if(!hit) missed++;
+      hit = 0;
+      sim_start = sim_end + sim_exp(60e6 / sim_rate);
+      sim_end   = sim_start + SIM_MINHOLD + sim_exp(sim_hold);
+      sim_key   = lrand48() % TOUCH_KEYS;
+    }
+    uint8_t key = TOUCH_read();
+    if(key) {
+      if(sim_now < sim_start || sim_now >= sim_end) falses++;
+      else if(key != sim_key + 1) wrong++;
+      else if(!hit) {
+        hit = 1;
+        detected++;
+        double lat = sim_now + tScan - sim_start;
+        latSum += lat;
+        if(lat > latMax) latMax = lat;
+      }
+    }
+    sim_now += tScan;
+    tScans  += SIM_WAKEUP + tScan;
+    if(!key) continue;
+    while(key) {                              // send frames while the key is touched
+      sim_now += sim_frame;
+      key = TOUCH_read();
+      sim_now += tScan;
+    }
+  }
+
+  printf("Pads: %.1fpF +/-10%%, finger %.1fpF, drift %.1fpF/%.0fs, noise %.1f LSB, "
+         "R %dk, sample at %.1fus\n", sim_pad, sim_finger, sim_drift, sim_dperiod / 1e6,
+         sim_noise, TOUCH_R / 1000, sim_sample);
+  printf("Readings: %.0f without finger, %.0f with finger (pad 1, sum of %d)\n",
+         TOUCH_SAMPLES * 1023 * (1 - exp(-sim_sample / (TOUCH_R * sim_c[0] * 1e-6))),
+         TOUCH_SAMPLES * 1023 * (1 - exp(-sim_sample / (TOUCH_R * (sim_c[0] + sim_finger)
+         * 1e-6))), TOUCH_SAMPLES);
+  printf("\n%-28s  %10ld\n", "Touches", touches);
+  printf("%-28s  %10ld\n", "Detected", detected);
+  printf("%-28s  %10ld\n", "Missed", missed);
+  printf("%-28s  %10ld\n", "False / wrong key", falses + wrong);
+  printf("%-28s  %10.0f\n", "Latency mean/ms", detected ? latSum / detected / 1000 : 0);
+  printf("%-28s  %10.0f\n", "Latency max/ms", latMax / 1000);
+  printf("%-28s  %10ld / %ld\n", "Scan cycles slow / fast", slow, fast);
+
+  printf("\n%-28s  %10.0f\n", "Scan time/us", tScan);
+  printf("%-28s  %10.2f\n", "Charge per scan cycle/uC", qCycle);
+  printf("%-28s  %10.2f\n", "Energy per scan cycle/uJ", qCycle * vdd);
+  printf("%-28s  %10.1f\n", "Idle current/uA", SIM_STANDBY * 1000
+         + qCycle * 1000 / TOUCH_SLOW);
+  printf("%-28s  %10.1f\n", "Current with finger near/uA", SIM_STANDBY * 1000
+         + qCycle * 1000 / TOUCH_FAST);
+  printf("%-28s  %10.1f\n", "Average current/uA", SIM_STANDBY * 1000
+         + (tScans * mcu * 1e-3) / sim_time * 1e6);
+  printf("(%.0f s, %.1f touches/min, MCU %.1f mA at %.1fV, standby %.0f uA, reading %.1fus)\n",
+         sim_time / 1e6, sim_rate, mcu, vdd, SIM_STANDBY * 1000, tSample);
+  return (falses || wrong) ? 1 : 0;
+}
@@ -0,0 +1,329 @@
+// ===================================================================================
+// Simulation of Wake-on-IR with a Duty-Cycled Receiver (Host)
+// ===================================================================================
+//
+// Runs WAKE_check() and WAKE_idle() of src/wake.c against the transmissions of a
+// remote control. The key presses arrive as a Poisson process, each key is held for
+// an exponentially distributed time, and the transmissions are recorded from the
+// encoders of src/protocols.c by the IR_HOST backend (real timings, repeat frames and
+// pauses). The protocol changes with every press, unless one is selected with -P.
+//
+// The AWU wakes the MCU every -p ms. As in the main loop, the receiver is switched on
+// after the wake-up time from standby, the keys are debounced (1ms) and WAKE_check()
+// is called. If it detects IR activity, WAKE_idle(WAKE_IDLE) keeps the MCU awake until
+// the transmission has ended (where a repeater or learning remote would capture it).
+// AWU events while the MCU is awake are lost. The receiver model:
+// - its output is valid -u us after power-up, before that it is low with -g (AGC
+//   settling), otherwise high,
+// - it detects a mark after the carrier has been present for -m us (while valid),
+//   and its output stays low until the end of the mark,
+// - each read of the output takes -q us (one pass of the polling loop).
+//
+// A press is detected if there was a detection between its first and last edge. The
+// latency is the time from its first edge to the detection, the frames starting after
+// the detection could be captured completely. False wakes are detections without any
+// transmission. The average current is calculated from the standby current (9uA),
+// the time the MCU is awake (-i mA) and the time the receiver is on (-r mA). The idle
+// current is the average current without any key presses. With -v, the debug output
+// of src/wake.c (src/debug.c) is shown on stderr.
+//
+// Build:  make sim  (or: cc -O2 -DIR_HOST -DWAKE_HOST -DDBG_HOST -I. -Isrc -Isim
+//                        -o bin/wake_sim sim/wake_sim.c src/wake.c src/debug.c
+//                        sim/debugger.c src/protocols.c src/ir.c -lm)
+// Usage:  bin/wake_sim [-p period ms] [-w window us] [-e settle us] [-u startup us]
+//                      [-m detect us] [-g] [-q poll us] [-i mA] [-r mA] [-P protocol]
+//                      [-k presses/min] [-h hold ms] [-t seconds] [-s seed] [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+#include "protocols.h"
+#include "wake.h"
+#include "debug.h"
+#include "debugger.h"
+
+#define SIM_STANDBY       0.009               // standby current in mA
+#define SIM_WAKEUP        200.0               // wake-up time from standby in us
+#define SIM_DEBOUNCE      1000                // key debounce of the main loop in us
+#define SIM_PROTOCOLS     7
+
+static const char* sim_names[SIM_PROTOCOLS] = {
+  "NEC", "SAM", "RC5", "SON", "RMM", "XMP", "SAM48"
+};
+
+// Parameters
+uint16_t WAKE_HOST_settle = WAKE_SETTLE;      // firmware settle time in us
+uint16_t WAKE_HOST_window = WAKE_WINDOW;      // firmware window in us
+static double sim_period  = WAKE_PERIOD;      // AWU period in ms
+static double sim_startup = 300;              // receiver output valid after us
+static double sim_detect  = 150;              // min carrier for detection in us
+static int    sim_glitch  = 0;                // output low until valid
+static double sim_poll    = 7;                // time per read of the output in us
+static double sim_mcu     = 1.2;              // MCU current while awake in mA
+static double sim_rx      = 0.4;              // receiver current in mA
+static int    sim_proto   = -1;               // fixed protocol or -1
+static double sim_rate    = 6;                // presses per minute
+static double sim_hold    = 300e3;            // mean hold time in us
+static double sim_time    = 3600e6;           // simulated time in us
+
+// Transmission of one key press
+typedef struct {
+  int     proto;
+  double  start, end;                         // first and last edge (absolute)
+  int     first, nmarks;                      // marks in sim_mark[]
+  int     nframes;
+  double* frame;                              // start of each frame (absolute)
+  double  detect;                             // time of first detection or -1
+} sim_press_t;
+
+// All marks of all presses: start, end (absolute)
+static double* sim_mark;
+static int     sim_nmarks, sim_capacity;
+
+// ===================================================================================
+// Recording of the Firmware's Transmissions
+// ===================================================================================
+static sim_press_t* rec_press;                // press being recorded
+static double       rec_time;                 // current time in us
+static double       rec_hold;                 // end of key hold
+static int          rec_level, rec_frame;
+
+void IR_HOST_carrier(uint32_t freq) {
+  (void)freq;
+}
+
+void IR_HOST_edge(uint8_t mark, uint32_t ticks) {
+  double us = ticks * 1000000.0 / F_CPU;
+  if(mark && !rec_level) {                    // new mark
+    if(sim_nmarks == sim_capacity) {
+      sim_capacity = sim_capacity ? sim_capacity * 2 : 4096;
+      sim_mark = realloc(sim_mark, sim_capacity * 2 * sizeof(double));
+    }
+    if(rec_frame) {                           // first mark of a frame
+      rec_press->frame = realloc(rec_press->frame, (rec_press->nframes + 1) * sizeof(double));
+      rec_press->frame[rec_press->nframes++] = rec_time;
+      rec_frame = 0;
+    }
+    sim_mark[sim_nmarks * 2] = rec_time;
+    sim_nmarks++;
+    rec_press->nmarks++;
+  }
+  rec_time += us;
+  if(mark) {
+    sim_mark[sim_nmarks * 2 - 1] = rec_time;
+    rec_press->end = rec_time;
+  }
+  rec_level = mark;
+}
+
+// Press model: the encoders ask after each frame whether the key is still down
+uint8_t KEY_read(void) {
+  rec_frame = 1;
+  return rec_time < rec_hold;
+}
+
+// Record the transmission of a press starting at time start
+static void rec_record(sim_press_t* p, int proto, double start, double hold) {
+  uint32_t r = (uint32_t)lrand48();
+  memset(p, 0, sizeof(*p));
+  p->proto  = proto;
+  p->start  = start;
+  p->first  = sim_nmarks;
+  p->detect = -1;
+  rec_press = p;
+  rec_time  = start; rec_hold = start + hold;
+  rec_level = 0; rec_frame = 1;
+  switch(proto) {
+    case 0: NEC_sendCode(r & 0xff, r >> 8);                  break;
+    case 1: SAM_sendCode(r & 0xff, r >> 8);                  break;
+    case 2: RC5_sendCode(r & 0x1f, r >> 8);                  break;
+    case 3: SON_sendCode(r & 0x1f, r >> 8, 12);              break;
+    case 4: RMM_sendCode(r, 24);                             break;
+    case 5: XMP_sendCode(r, r >> 8, r >> 16, r >> 4);        break;
+    case 6: SAM48_sendCode(r, r >> 16);                      break;
+  }
+}
+
+// ===================================================================================
+// Host Receiver Backend
+// ===================================================================================
+static double sim_now;                        // current time in us
+static double sim_power = -1;                 // receiver power-up time or -1 (off)
+static double sim_rx_on;                      // receiver on-time in us
+
+void WAKE_HOST_power(uint8_t on) {
+  if(on && sim_power < 0) sim_power = sim_now;
+  if(!on && sim_power >= 0) {
+    sim_rx_on += sim_now - sim_power;
+    sim_power = -1;
+  }
+}
+
+// Receiver output at the current time (0: carrier detected)
+uint8_t WAKE_HOST_read(void) {
+  double valid = sim_power + sim_startup;
+  int lo = 0, hi = sim_nmarks;
+  sim_now += sim_poll;
+  if(sim_power < 0) return 1;
+  if(sim_now < valid) return !sim_glitch;
+  while(lo < hi) {                            // first mark ending after now
+    int mid = (lo + hi) / 2;
+    if(sim_mark[mid * 2 + 1] <= sim_now) lo = mid + 1;
+    else hi = mid;
+  }
+  if(lo == sim_nmarks || sim_mark[lo * 2] > sim_now) return 1;
+  return sim_now - fmax(sim_mark[lo * 2], valid) < sim_detect;
+}
+
+void WAKE_HOST_delay(uint16_t us) {
+  sim_now += us;
+}
+
+uint32_t WAKE_HOST_now(void) {
+  return (uint32_t)sim_now;
+}
+
+// ===================================================================================
+// Simulation
+// ===================================================================================
+
+// Exponentially distributed random number with the given mean
+static double sim_exp(double mean) {
+  return -log(1.0 - drand48()) * mean;
+}
+
+// Press active at time t (first edge <= t <= last edge) or NULL
+static sim_press_t* sim_find(sim_press_t* press, int n, double t) {
+  for(int i=0; i<n; i++) {
+    if(press[i].start <= t && t <= press[i].end) return &press[i];
+    if(press[i].start > t) break;
+  }
+  return NULL;
+}
+
+// Run the AWU wake-ups over all presses, returns charge in mAs
+static double sim_run(sim_press_t* press, int n, unsigned long* checks,
+                      unsigned long* wakes, unsigned long* falses, double* awake) {
+  double tick = 0;
+  *checks = *wakes = *falses = 0; *awake = 0;
+  sim_now = 0; sim_power = -1; sim_rx_on = 0;
+  while((tick += sim_period * 1000) < sim_time) {
+    if(tick < sim_now) continue;              // still awake, AWU event lost
+    double begin = tick;
+    sim_now = tick + SIM_WAKEUP;
+    (*checks)++;
+    WAKE_on();                                // as main.c: receiver on, debounce keys
+    WAKE_HOST_delay(SIM_DEBOUNCE);
+    if(WAKE_check()) {
+      sim_press_t* p = sim_find(press, n, sim_now);
+      (*wakes)++;
+      if(!p) (*falses)++;
+      else if(p->detect < 0) p->detect = sim_now;
+      WAKE_idle(WAKE_IDLE);
+      WAKE_off();
+      DBG_drain(10);
+    }
+    *awake += sim_now - begin;
+  }
+  return (sim_time * SIM_STANDBY + *awake * sim_mcu + sim_rx_on * sim_rx) / 1e6;
+}
+
+static void usage(void) {
+  fprintf(stderr, "Usage: wake_sim [-p period ms] [-w window us] [-e settle us] "
+                  "[-u startup us] [-m detect us] [-g] [-q poll us] [-i mA] [-r mA] "
+                  "[-P protocol] [-k presses/min] [-h hold ms] [-t seconds] [-s seed] [-v]\n");
+  exit(2);
+}
+
+int main(int argc, char** argv) {
+  long seed = time(NULL);
+  int opt;
+  while((opt = getopt(argc, argv, "p:w:e:u:m:gq:i:r:P:k:h:t:s:v")) != -1) {
+    switch(opt) {
+      case 'p': sim_period = atof(optarg);                   break;
+      case 'w': WAKE_HOST_window = atoi(optarg);             break;
+      case 'e': WAKE_HOST_settle = atoi(optarg);             break;
+      case 'u': sim_startup = atof(optarg);                  break;
+      case 'm': sim_detect = atof(optarg);                   break;
+      case 'g': sim_glitch = 1;                              break;
+      case 'q': sim_poll = atof(optarg);                     break;
+      case 'i': sim_mcu = atof(optarg);                      break;
+      case 'r': sim_rx = atof(optarg);                       break;
+      case 'P':
+        for(sim_proto=SIM_PROTOCOLS-1; sim_proto>=0; sim_proto--)
+          if(!strcmp(optarg, sim_names[sim_proto])) break;
+        if(sim_proto < 0) usage();
+        break;
+      case 'k': sim_rate = atof(optarg);                     break;
+      case 'h': sim_hold = atof(optarg) * 1000;              break;
+      case 't': sim_time = atof(optarg) * 1e6;               break;
+      case 's': seed = atol(optarg);                         break;
+      case 'v': DBG_HOST_attached = 1;                       break;
+      default:  usage();
+    }
+  }
+  if(sim_period < 1 || sim_poll <= 0 || sim_rate <= 0) usage();
+  srand48(seed);
+
+  // Idle: no key presses
+  unsigned long checks, wakes, falses;
+  double awake;
+  double idle = sim_run(NULL, 0, &checks, &wakes, &falses, &awake) / sim_time * 1e9;
+  unsigned long idle_falses = falses;
+
+  // Key presses
+  int n = 0, capacity = 0;
+  sim_press_t* press = NULL;
+  double t = sim_exp(60e6 / sim_rate);
+  while(t < sim_time) {
+    if(n == capacity) {
+      capacity = capacity ? capacity * 2 : 256;
+      press = realloc(press, capacity * sizeof(sim_press_t));
+    }
+    rec_record(&press[n], sim_proto >= 0 ? sim_proto : n % SIM_PROTOCOLS, t, sim_exp(sim_hold));
+    t = fmax(t + sim_exp(60e6 / sim_rate), press[n].end + 10e3);
+    n++;
+  }
+  double charge = sim_run(press, n, &checks, &wakes, &falses, &awake);
+
+  printf("period %.0fms, settle %dus, window %dus, receiver: valid after %.0fus%s, "
+         "detect %.0fus\n", sim_period, WAKE_HOST_settle, WAKE_HOST_window, sim_startup,
+         sim_glitch ? " (low before)" : "", sim_detect);
+  printf("%-8s %8s %9s %16s %14s\n", "protocol", "presses", "detected", "latency mean/max",
+         "frames missed");
+  for(int k=-1; k<SIM_PROTOCOLS; k++) {
+    int presses = 0, detected = 0;
+    unsigned long frames = 0, missed = 0;
+    double lat = 0, lat_max = 0;
+    for(int i=0; i<n; i++) {
+      sim_press_t* p = &press[i];
+      if(k >= 0 && p->proto != k) continue;
+      presses++;
+      frames += p->nframes;
+      if(p->detect < 0) {
+        missed += p->nframes;
+        continue;
+      }
+      detected++;
+      lat += p->detect - p->start;
+      lat_max = fmax(lat_max, p->detect - p->start);
+      for(int f=0; f<p->nframes && p->frame[f] < p->detect; f++) missed++;
+    }
+    if(!presses) continue;
+    printf("%-8s %8d %8.1f%% %7.0fms/%5.0fms %13.1f%%\n", k < 0 ? "all" : sim_names[k],
+           presses, 100.0 * detected / presses, detected ? lat / detected / 1e3 : 0,
+           lat_max / 1e3, frames ? 100.0 * missed / frames : 0);
+  }
+  printf("checks: %lu, wakes: %lu, false wakes: %lu (idle: %lu)\n", checks, wakes, falses,
+         idle_falses);
+  printf("idle current: %.1fuA (%.1f x standby), with presses: %.1fuA\n", idle,
+         idle / (SIM_STANDBY * 1000), charge / sim_time * 1e9);
+
+  for(int i=0; i<n; i++) free(press[i].frame);
+  free(press);
+  free(sim_mark);
+  return 0;
+}
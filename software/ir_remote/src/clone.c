@@ -0,0 +1,252 @@
+// ===================================================================================
+// Remote-to-Remote Cloning over IrDA SIR for CH32V003                        * v1.0 *
+// ===================================================================================
+
+#include "clone.h"
+#include "debug.h"
+
+#if CLONE_ENABLE > 0 || defined(CLONE_HOST)
+
+#ifndef CLONE_HOST
+// ===================================================================================
+// USART1 IrDA Link
+// ===================================================================================
+#include "system.h"
+#include "gpio.h"
+
+// USART1 pins depending on remapping
+#if   CLONE_REMAP == 0
+  #define CLONE_TX        PD5
+  #define CLONE_RX        PD6
+#elif CLONE_REMAP == 1
+  #define CLONE_TX        PD0
+  #define CLONE_RX        PD1
+#elif CLONE_REMAP == 2
+  #define CLONE_TX        PD6
+  #define CLONE_RX        PD5
+#elif CLONE_REMAP == 3
+  #define CLONE_TX        PC0
+  #define CLONE_RX        PC1
+#else
+  #error Unknown CLONE_REMAP
+#endif
+
+#define CLONE_FREE(PIN)   (PIN != CLONE_TX && PIN != CLONE_RX)
+_Static_assert(CLONE_FREE(PIN_KEY1) && CLONE_FREE(PIN_KEY2) && CLONE_FREE(PIN_KEY3) &&
+               CLONE_FREE(PIN_KEY4) && CLONE_FREE(PIN_KEY5) && CLONE_FREE(PIN_LED),
+               "USART1 pins of CLONE_REMAP are used by keys or IR LED");
+_Static_assert(F_CPU >= 16UL * CLONE_BAUD, "CLONE_BAUD is above F_CPU / 16");
+#if CLONE_REMAP == 1 && DBG_ENABLE > 0
+  #error CLONE_REMAP 1 uses PD1 (SWIO), which the debug output needs
+#endif
+
+// Init USART1 in IrDA SIR normal mode
+void CLONE_init(void) {
+  RCC->APB2PCENR |= RCC_AFIOEN      // enable auxiliary I/O functions
+                  | RCC_USART1EN;   // enable USART module
+  PORT_enable(CLONE_TX);            // enable I/O port of USART pins
+  AFIO->PCFR1    |= ((CLONE_REMAP & 1) ? AFIO_PCFR1_USART1_REMAP : 0)
+                  | ((CLONE_REMAP & 2) ? ((uint32_t)1 << 21) : 0);  // USART1_RM1
+  PIN_alternate(CLONE_TX);          // TX pin to alternate output
+  PIN_input_PU(CLONE_RX);           // RX pin to input pullup
+  USART1->BRR     = (F_CPU + CLONE_BAUD / 2) / CLONE_BAUD;  // set baud rate
+  USART1->GPR     = 1;              // prescaler must be 1 in IrDA normal mode
+  USART1->CTLR3   = USART_CTLR3_IREN;                       // enable IrDA mode
+  USART1->CTLR1   = USART_CTLR1_UE | USART_CTLR1_TE | USART_CTLR1_RE;
+}
+
+// Start of a frame: switch off receiver (transceiver echo)
+static void CLONE_begin(void) {
+  USART1->CTLR1 &= ~USART_CTLR1_RE;
+}
+
+// Send byte
+static void CLONE_putc(uint8_t data) {
+  while(!(USART1->STATR & USART_STATR_TXE));
+  USART1->DATAR = data;
+}
+
+// End of a frame: wait until sent, switch on receiver
+static void CLONE_end(void) {
+  while(!(USART1->STATR & USART_STATR_TC));
+  (void)USART1->DATAR;              // discard echo
+  USART1->CTLR1 |= USART_CTLR1_RE;
+}
+
+// Wait for byte, returns -1 if none arrives within timeout ms
+static int CLONE_getc(uint16_t timeout) {
+  uint32_t ticks = (uint32_t)timeout * DLY_MS_TIME;
+  uint32_t start = STK->CNT;
+  while(!(USART1->STATR & USART_STATR_RXNE)) {
+    if(STK->CNT - start > ticks) return -1;
+  }
+  return USART1->DATAR;             // also clears overrun flag
+}
+
+// Give the other transceiver time to turn around
+#define CLONE_turn()      DLY_ms(CLONE_TURN)
+
+#else
+// ===================================================================================
+// Host Link (see sim/clone_sim.c)
+// ===================================================================================
+#define CLONE_begin()     CLONE_HOST_begin()
+#define CLONE_putc(data)  CLONE_HOST_putc(data)
+#define CLONE_end()       CLONE_HOST_end()
+#define CLONE_getc(t)     CLONE_HOST_getc(t)
+#define CLONE_turn()      CLONE_HOST_turn()
+
+#endif  // CLONE_HOST
+
+// ===================================================================================
+// Frames
+// ===================================================================================
+#define CLONE_SOF         0xA5                // start of frame
+#define CLONE_DATA        'D'                 // data block
+#define CLONE_POLL        'P'                 // request bitmap
+#define CLONE_ACK         'A'                 // bitmap of received blocks
+#define CLONE_BAD         1                   // broken frame (returned by CLONE_read)
+#define CLONE_BYTE        2                   // max time between bytes of a frame in ms
+#define CLONE_IDLE        (CLONE_POLLS / 2 + 1)  // max number of timeouts after first frame
+
+// CRC-16/CCITT nibble table
+static const uint16_t CLONE_CRC_table[16] = {
+  0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+  0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+// Update CRC with one byte
+static uint16_t CLONE_CRC(uint16_t crc, uint8_t data) {
+  crc = (crc << 4) ^ CLONE_CRC_table[(crc >> 12) ^ (data >> 4)];
+  crc = (crc << 4) ^ CLONE_CRC_table[(crc >> 12) ^ (data & 0x0F)];
+  return crc;
+}
+
+// Bitmap of count blocks
+static uint32_t CLONE_mask(uint8_t count) {
+  return (count >= 32) ? 0xFFFFFFFF : (((uint32_t)1 << count) - 1);
+}
+
+// Send frame: type, head bytes, then len bytes of data (zero padded to pad bytes)
+static void CLONE_frame(uint8_t type, const uint8_t* head, uint8_t hlen,
+                        const uint8_t* data, uint8_t len, uint8_t pad) {
+  uint16_t crc = CLONE_CRC(0xFFFF, type);
+  CLONE_begin();
+  CLONE_putc(CLONE_SOF);
+  CLONE_putc(type);
+  while(hlen--) {
+    CLONE_putc(*head);
+    crc = CLONE_CRC(crc, *head++);
+  }
+  for(uint8_t i=0; i<pad; i++) {
+    uint8_t b = (i < len) ? data[i] : 0;
+    CLONE_putc(b);
+    crc = CLONE_CRC(crc, b);
+  }
+  CLONE_putc(crc >> 8);
+  CLONE_putc(crc);
+  CLONE_end();
+}
+
+// Read frame into buffer (without SOF, type and CRC), returns type, 0 on timeout or
+// CLONE_BAD on a broken frame
+static uint8_t CLONE_read(uint8_t* frame, uint16_t timeout) {
+  int c;
+  uint8_t type, len;
+  uint16_t crc;
+  do {                                        // wait for start of frame
+    c = CLONE_getc(timeout);
+    if(c < 0) return 0;
+  } while(c != CLONE_SOF);
+  if((c = CLONE_getc(CLONE_BYTE)) < 0) return CLONE_BAD;
+  type = c;
+  switch(type) {
+    case CLONE_DATA: len = CLONE_BLOCK + 2; break;
+    case CLONE_POLL: len = 3; break;
+    case CLONE_ACK:  len = 4; break;
+    default:         return CLONE_BAD;
+  }
+  crc = CLONE_CRC(0xFFFF, type);
+  while(len--) {
+    if((c = CLONE_getc(CLONE_BYTE)) < 0) return CLONE_BAD;
+    *frame++ = c;
+    crc = CLONE_CRC(crc, c);
+  }
+  if((c = CLONE_getc(CLONE_BYTE)) < 0) return CLONE_BAD;
+  crc ^= c << 8;
+  if((c = CLONE_getc(CLONE_BYTE)) < 0) return CLONE_BAD;
+  crc ^= c;
+  return crc ? CLONE_BAD : type;
+}
+
+// ===================================================================================
+// Clone Functions
+// ===================================================================================
+
+// Send len bytes of buf, returns 0 on success
+uint8_t CLONE_send(const uint8_t* buf, uint16_t len) {
+  uint8_t  frame[4];
+  uint8_t  count = (len + CLONE_BLOCK - 1) / CLONE_BLOCK;
+  uint32_t missing = CLONE_mask(count);
+  if(!len || len > CLONE_SIZE) return 1;
+  for(uint8_t round=0; round<CLONE_ROUNDS; round++) {
+    for(uint8_t i=0; i<count; i++) {          // send missing blocks
+      if(!(missing & ((uint32_t)1 << i))) continue;
+      frame[0] = i; frame[1] = count;
+      CLONE_frame(CLONE_DATA, frame, 2, buf + i * CLONE_BLOCK,
+                  (len - i * CLONE_BLOCK > CLONE_BLOCK) ? CLONE_BLOCK : len - i * CLONE_BLOCK,
+                  CLONE_BLOCK);
+    }
+    for(uint8_t poll=0; ; poll++) {           // poll until bitmap is received
+      if(poll == CLONE_POLLS) return 1;
+      frame[0] = count; frame[1] = len; frame[2] = len >> 8;
+      CLONE_frame(CLONE_POLL, frame, 3, 0, 0, 0);
+      if(CLONE_read(frame, CLONE_TIMEOUT) == CLONE_ACK) break;
+    }
+    missing &= ~((uint32_t)frame[0] | (uint32_t)frame[1] << 8
+               | (uint32_t)frame[2] << 16 | (uint32_t)frame[3] << 24);
+    DBG_print("CLONE "); DBG_printD(round); DBG_write(' '); DBG_printH(missing); DBG_write('\n');
+    if(!missing) return 0;
+    CLONE_turn();
+  }
+  return 1;
+}
+
+// Receive up to max bytes into buf, returns number of bytes (0: failed)
+uint16_t CLONE_receive(uint8_t* buf, uint16_t max) {
+  uint8_t  frame[CLONE_BLOCK + 2];
+  uint32_t have = 0;                          // bitmap of received blocks
+  uint16_t size = 0;                          // size of data, 0 while incomplete
+  uint16_t timeout = CLONE_WAIT;              // wait for sender
+  uint8_t  idle = 0;
+  while(1) {
+    switch(CLONE_read(frame, timeout)) {
+      case CLONE_DATA:
+        if(frame[0] < CLONE_BLOCKS && frame[0] * CLONE_BLOCK < max) {
+          uint16_t pos = frame[0] * CLONE_BLOCK;
+          for(uint8_t i=0; i<CLONE_BLOCK && pos<max; i++) buf[pos++] = frame[i + 2];
+          have |= (uint32_t)1 << frame[0];
+        }
+        break;
+      case CLONE_POLL:
+        if((frame[1] | frame[2] << 8) > max) return 0;  // doesn't fit
+        if((have & CLONE_mask(frame[0])) == CLONE_mask(frame[0]))
+          size = frame[1] | frame[2] << 8;    // complete, answer repeated polls
+        frame[0] = have; frame[1] = have >> 8; frame[2] = have >> 16; frame[3] = have >> 24;
+        CLONE_turn();
+        CLONE_frame(CLONE_ACK, frame, 4, 0, 0, 0);
+        break;
+      case 0:                                 // timeout
+        if(timeout == CLONE_WAIT) return 0;   // no sender
+        if(++idle > CLONE_IDLE) return size;  // sender finished or gave up
+        continue;
+      default:                                // broken frame
+        if(++idle > CLONE_IDLE * CLONE_ROUNDS) return size;
+        continue;
+    }
+    timeout = CLONE_TIMEOUT * 2;              // sender is silent at most one timeout
+    idle = 0;
+  }
+}
+
+#endif  // CLONE_ENABLE || CLONE_HOST
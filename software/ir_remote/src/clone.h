@@ -0,0 +1,108 @@
+// ===================================================================================
+// Remote-to-Remote Cloning over IrDA SIR for CH32V003                        * v1.0 *
+// ===================================================================================
+//
+// Transfers a block of data (e.g. the code store of a remote) from one unit to another
+// by USART1 in IrDA SIR mode. The data is sent in frames of CLONE_BLOCK bytes, each
+// protected by a CRC-16. After a burst of frames the sender polls the receiver, which
+// answers with a bitmap of the blocks received so far. Only the missing blocks are
+// sent again, until the bitmap is complete or CLONE_ROUNDS rounds have passed. A lost
+// POLL or ACK only costs another POLL (up to CLONE_POLLS per round).
+//
+// Frames:
+// -------
+// DATA  SOF 'D' index count payload[CLONE_BLOCK] CRC   sender   -> receiver
+// POLL  SOF 'P' count size_low size_high          CRC   sender   -> receiver
+// ACK   SOF 'A' bitmap[4]                         CRC   receiver -> sender
+//
+// SOF is 0xA5, CRC is CRC-16/CCITT (0xFFFF, not reflected) over type to payload, high
+// byte first. A DATA frame carries CLONE_BLOCK + 6 bytes, i.e. 84% of the bytes on
+// the wire are payload with the default block size of 32 bytes. Larger blocks raise
+// this (91% at 64 bytes), but each lost frame costs more air time. Use the simulator
+// in sim/ to compare block sizes and loss rates. With 32-byte blocks at 57600 baud,
+// 1kB of data takes about 215ms (4.8kB/s) on a clean link, 250ms with 10% and 420ms
+// with 30% of the frames lost.
+//
+// Functions available:
+// --------------------
+// CLONE_init()             init USART1 in IrDA mode
+// CLONE_send(buf, len)     send len bytes of buf, returns 0 on success
+// CLONE_receive(buf, max)  receive up to max bytes into buf, returns length (0: failed)
+//
+// Notes:
+// ------
+// - Cloning is disabled unless CLONE_ENABLE is set to "1" in config.h.
+// - The main loop doesn't start a transfer by itself, the application calls these
+//   functions with its own data, e.g. from a key action in config.h:
+//   #define KEY5 {CLONE_init(); CLONE_send(store, sizeof(store));}
+// - This needs an IrDA SIR transceiver (e.g. TFDU4101) on the USART1 pins, the IR
+//   LED and a 38kHz IR receiver can't be used. The pins are selected by CLONE_REMAP:
+//   0: TX PD5, RX PD6;  1: TX PD0, RX PD1;  2: TX PD6, RX PD5;  3: TX PC0, RX PC1.
+//   They must not be used by the keys. With the default key pins only mapping 1 is
+//   free, but PD1 is also SWIO: the transceiver's RXD output drives the pin, so the
+//   programmer can't connect (flashing, debug output) while the transceiver is fitted
+//   and powered, and DBG_ENABLE can't be combined with it. Move KEY3/KEY4 (mapping 0
+//   or 2) or KEY5 (mapping 3, PC0 must then not be PIN_RXOUT) for debuggable boards.
+// - The link is half-duplex, the receiver is switched off while sending, so that the
+//   transceiver's echo is ignored.
+// - The USART samples each bit 16 times, so CLONE_BAUD can be at most F_CPU / 16:
+//   57600 baud at 1.5MHz (115200 needs at least 1.84MHz, checked at compile time).
+//   The CRC is calculated on the fly by a nibble table, so at 1.5MHz there are enough
+//   cycles per byte to keep up with the link by polling.
+// - CLONE_send() and CLONE_receive() block until the transfer is finished or failed.
+// - If CLONE_HOST is defined (host builds), USART1 is replaced by the CLONE_HOST_*()
+//   functions, which have to be provided by the host program (see sim/clone_sim.c).
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <config.h>
+#include <stdint.h>
+
+// ===================================================================================
+// Clone Parameters
+// ===================================================================================
+#ifndef CLONE_ENABLE
+  #define CLONE_ENABLE    0                   // 1: include cloning functions
+#endif
+#ifndef CLONE_REMAP
+  #define CLONE_REMAP     0                   // USART1 pin mapping (see above)
+#endif
+#ifndef CLONE_BAUD
+  #define CLONE_BAUD      57600               // IrDA SIR baud rate (max F_CPU / 16)
+#endif
+#ifndef CLONE_BLOCK
+  #define CLONE_BLOCK     32                  // payload bytes per DATA frame
+#endif
+#define CLONE_BLOCKS      32                  // max number of blocks (bitmap width)
+#define CLONE_SIZE        (CLONE_BLOCK * CLONE_BLOCKS)  // max data size in bytes
+#define CLONE_ROUNDS      16                  // max number of rounds with data frames
+#define CLONE_POLLS       16                  // max number of polls per round
+#define CLONE_TIMEOUT     20                  // ACK/frame timeout in ms
+#define CLONE_WAIT        5000                // max time to wait for a sender in ms
+#define CLONE_TURN        1                   // IrDA link turnaround time in ms
+
+// ===================================================================================
+// Clone Functions
+// ===================================================================================
+void CLONE_init(void);                                  // init USART1 in IrDA mode
+uint8_t  CLONE_send(const uint8_t* buf, uint16_t len);  // send data, 0: success
+uint16_t CLONE_receive(uint8_t* buf, uint16_t max);     // receive data, returns length
+
+#ifdef CLONE_HOST
+// ===================================================================================
+// Link Backend for Host Builds
+// ===================================================================================
+void CLONE_HOST_begin(void);                  // start of a frame
+void CLONE_HOST_putc(uint8_t data);           // send byte
+void CLONE_HOST_end(void);                    // end of a frame
+int  CLONE_HOST_getc(uint16_t timeout);       // byte or -1 if none within timeout ms
+void CLONE_HOST_turn(void);                   // link turnaround (CLONE_TURN ms)
+#endif
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,140 @@
+// ===================================================================================
+// Non-Blocking Debug Output over SWIO for CH32V003                           * v1.0 *
+// ===================================================================================
+
+#include "debug.h"
+
+#if DBG_ENABLE > 0 || defined(DBG_HOST)
+
+#ifndef DBG_HOST
+// ===================================================================================
+// Debug Module Mailbox
+// ===================================================================================
+#include "system.h"
+
+#define DBG_DATA0         (*(volatile uint32_t*)0xE00000F4)  // DMDATA0
+#define DBG_DATA1         (*(volatile uint32_t*)0xE00000F8)  // DMDATA1
+#define DBG_now()         STK->CNT
+#define DBG_TICKS(ms)     ((uint32_t)(ms) * DLY_MS_TIME)
+
+#else
+// ===================================================================================
+// Host Mailbox (see sim/debugger.c), each flush counts as 1us
+// ===================================================================================
+volatile uint32_t DBG_HOST_data0, DBG_HOST_data1;
+static uint32_t DBG_HOST_time;
+
+#define DBG_DATA0         DBG_HOST_data0
+#define DBG_DATA1         DBG_HOST_data1
+#define DBG_now()         DBG_HOST_time
+#define DBG_TICKS(ms)     ((uint32_t)(ms) * 1000)
+
+#endif  // DBG_HOST
+
+_Static_assert(DBG_BUFFER >= 8 && DBG_BUFFER <= 128 && !(DBG_BUFFER & (DBG_BUFFER - 1)),
+               "DBG_BUFFER must be a power of 2 between 8 and 128");
+
+#define DBG_MASK          (DBG_BUFFER - 1)
+#define DBG_FULL          0x80                // mailbox holds unread characters
+
+static char    DBG_buffer[DBG_BUFFER];        // ring buffer
+static uint8_t DBG_head, DBG_tail;            // write and read position
+static uint8_t DBG_sent;                      // mailbox was written since last check
+static uint8_t DBG_attached;                  // programmer has read the mailbox
+
+// ===================================================================================
+// Ring Buffer
+// ===================================================================================
+
+// Write character into ring buffer, drop the oldest one if full
+void DBG_write(char c) {
+  DBG_buffer[DBG_head] = c;
+  DBG_head = (DBG_head + 1) & DBG_MASK;
+  if(DBG_head == DBG_tail) DBG_tail = (DBG_tail + 1) & DBG_MASK;
+}
+
+// Write string
+void DBG_print(const char* str) {
+  while(*str) DBG_write(*str++);
+}
+
+// Write string and newline
+void DBG_println(const char* str) {
+  DBG_print(str);
+  DBG_write('\n');
+}
+
+// Write unsigned decimal number
+void DBG_printD(uint32_t value) {
+  char digits[10];
+  uint8_t i = 0;
+  do {
+    digits[i++] = '0' + value % 10;
+    value /= 10;
+  } while(value);
+  while(i) DBG_write(digits[--i]);
+}
+
+// Write 32-bit hex number (8 digits)
+void DBG_printH(uint32_t value) {
+  for(uint8_t i=8; i; i--) {
+    uint8_t digit = (value >> 28);
+    DBG_write(digit + (digit < 10 ? '0' : 'A' - 10));
+    value <<= 4;
+  }
+}
+
+// Number of characters in ring buffer
+uint8_t DBG_pending(void) {
+  return (DBG_head - DBG_tail) & DBG_MASK;
+}
+
+// ===================================================================================
+// Mailbox
+// ===================================================================================
+
+// Move up to 7 characters into the mailbox if the programmer has read the previous
+// ones, returns the number of characters left in the ring buffer
+uint8_t DBG_flush(void) {
+  uint8_t data[8] = {0};
+  uint8_t count = DBG_pending();
+  #ifdef DBG_HOST
+  DBG_HOST_time++;
+  DBG_HOST_poll();
+  #endif
+  if(DBG_DATA0 & DBG_FULL) return count;      // not read yet (or no programmer)
+  if(DBG_sent) {
+    DBG_sent = 0;
+    DBG_attached = 1;
+  }
+  if(!count) return 0;
+  if(count > 7) count = 7;
+  data[0] = DBG_FULL | (count + 4);
+  for(uint8_t i=1; i<=count; i++) {
+    data[i] = DBG_buffer[DBG_tail];
+    DBG_tail = (DBG_tail + 1) & DBG_MASK;
+  }
+  DBG_DATA1 = data[4] | (uint32_t)data[5] << 8 | (uint32_t)data[6] << 16
+            | (uint32_t)data[7] << 24;
+  DBG_DATA0 = data[0] | (uint32_t)data[1] << 8 | (uint32_t)data[2] << 16
+            | (uint32_t)data[3] << 24;                   // DMDATA0 last: mailbox full
+  DBG_sent = 1;
+  return DBG_pending();
+}
+
+// Flush until the ring buffer is empty and the programmer has read the mailbox. Returns
+// immediately if no programmer has read the mailbox yet, gives up after ms.
+void DBG_drain(uint16_t ms) {
+  uint32_t start = DBG_now();
+  DBG_flush();
+  if(DBG_sent && !DBG_attached) return;       // no programmer
+  while(DBG_pending() || (DBG_DATA0 & DBG_FULL)) {
+    if((uint32_t)(DBG_now() - start) > DBG_TICKS(ms)) {
+      DBG_attached = 0;                       // programmer gone
+      return;
+    }
+    DBG_flush();
+  }
+}
+
+#endif  // DBG_ENABLE || DBG_HOST
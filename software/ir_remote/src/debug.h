@@ -0,0 +1,104 @@
+// ===================================================================================
+// Non-Blocking Debug Output over SWIO for CH32V003                           * v1.0 *
+// ===================================================================================
+//
+// Debug messages are written into a ring buffer in RAM and moved from there into the
+// mailbox of the debug module (DMDATA0/DMDATA1), which the programmer reads over the
+// single-wire debug interface (SWIO). The mailbox holds up to 7 characters, the
+// framing is the one of ch32v003fun's debug printf, so it can be shown by the
+// terminal of minichlink ("minichlink -T") or wlink ("wlink sdi-print").
+//
+// Mailbox:
+// --------
+// DMDATA0  byte 0: 0x80 | (count + 4), bytes 1..3: characters 0..2
+// DMDATA1  bytes 0..3: characters 3..6
+// The MCU only writes the mailbox if bit 7 of DMDATA0 is clear, the programmer clears
+// it after reading. Without a programmer the bit stays set after the first message,
+// so nothing else is written and the ring buffer drops the oldest pending output.
+//
+// Writing into the ring buffer takes a few cycles and never waits. DBG_flush() moves
+// at most one mailbox worth of characters and returns immediately if the programmer
+// hasn't read the previous ones, so it can be called from the main loop at any time.
+// Only DBG_drain(ms) waits (up to ms milliseconds), it is meant for the main loop
+// right before going to standby, where the SWIO link doesn't work anymore.
+//
+// Functions available:
+// --------------------
+// DBG_write(c)             write character into ring buffer
+// DBG_print(str)           write string
+// DBG_println(str)         write string and newline
+// DBG_printD(n)            write unsigned decimal number
+// DBG_printH(n)            write 32-bit hex number (8 digits)
+// DBG_flush()              move up to 7 characters into the mailbox if it is free
+// DBG_drain(ms)            flush until empty, programmer gone or ms milliseconds
+// DBG_pending()            number of characters in the ring buffer
+//
+// Notes:
+// ------
+// - Debug output is disabled unless DBG_ENABLE is set to "1" in config.h, all
+//   functions are then replaced by empty macros and cost neither flash nor RAM.
+// - Don't call DBG_flush() or DBG_drain() while sending IR: an access of the debug
+//   module by the programmer stalls the MCU for a few cycles. Writing into the ring
+//   buffer is safe anywhere.
+// - If DBG_HOST is defined (host builds), the mailbox is a RAM variable and the
+//   programmer is played by DBG_HOST_poll(), which has to be provided by the host
+//   program (see sim/debugger.c), so messages of the firmware code show up on the
+//   console of the simulators.
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <config.h>
+#include <stdint.h>
+
+// ===================================================================================
+// Debug Parameters
+// ===================================================================================
+#ifndef DBG_ENABLE
+  #define DBG_ENABLE      0                   // 1: include debug output
+#endif
+#ifndef DBG_BUFFER
+  #define DBG_BUFFER      64                  // ring buffer size (power of 2, max 128)
+#endif
+
+#if DBG_ENABLE > 0 || defined(DBG_HOST)
+// ===================================================================================
+// Debug Functions
+// ===================================================================================
+void DBG_write(char c);                       // write character into ring buffer
+void DBG_print(const char* str);              // write string
+void DBG_println(const char* str);            // write string and newline
+void DBG_printD(uint32_t value);              // write unsigned decimal number
+void DBG_printH(uint32_t value);              // write 32-bit hex number
+uint8_t DBG_flush(void);                      // move characters into mailbox if free
+void DBG_drain(uint16_t ms);                  // flush until empty or ms milliseconds
+uint8_t DBG_pending(void);                    // number of characters in ring buffer
+
+#else
+
+#define DBG_write(c)
+#define DBG_print(str)
+#define DBG_println(str)
+#define DBG_printD(value)
+#define DBG_printH(value)
+#define DBG_flush()       0
+#define DBG_drain(ms)
+#define DBG_pending()     0
+
+#endif  // DBG_ENABLE || DBG_HOST
+
+#ifdef DBG_HOST
+// ===================================================================================
+// Mailbox Backend for Host Builds
+// ===================================================================================
+extern volatile uint32_t DBG_HOST_data0;      // replaces DMDATA0
+extern volatile uint32_t DBG_HOST_data1;      // replaces DMDATA1
+void DBG_HOST_poll(void);                     // programmer reads the mailbox
+#endif
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,157 @@
+// ===================================================================================
+// Factory Test Mode for CH32V003                                             * v1.0 *
+// ===================================================================================
+
+#include "factory.h"
+
+#if FACTORY_ENABLE > 0 || defined(IR_HOST)
+
+#include "ir.h"
+#include "protocols.h"
+#include "debug.h"
+#include "ladder.h"
+
+// Report telegram: NEC timing at double speed
+static const PD_protocol_t FACTORY_protocol = {
+  IR_ticks(4500), IR_ticks(2250),             // header
+  IR_ticks(281.25),                           // bit mark
+  IR_ticks(281.25), IR_ticks(843.75),         // "0" and "1" space
+  IR_ticks(281.25), IR_ticks(10000),          // stop mark and end of sequence
+  PD_LSB_FIRST
+};
+
+// Timing calibration: marks and spaces of 250us to 4ms
+static const uint32_t FACTORY_timing[] = {
+  IR_ticks( 250), IR_ticks( 250), IR_ticks( 500), IR_ticks( 500),
+  IR_ticks(1000), IR_ticks(1000), IR_ticks(2000), IR_ticks(2000),
+  IR_ticks(4000), IR_ticks(4000)
+};
+
+#ifndef IR_HOST
+// ===================================================================================
+// Unit Information
+// ===================================================================================
+extern uint8_t _sinit[], _data_lma[], _data_vma[], _edata[];  // see ld/ch32v003.ld
+
+// CRC-32 nibble table (reflected, polynomial 0x04C11DB7)
+static const uint32_t FACTORY_CRC_table[16] = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4,
+  0x4DB26158, 0x5005713C, 0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+  0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+// CRC-32 of the flash image (code and initial values of data)
+static uint32_t FACTORY_hash(void) {
+  const uint8_t* ptr = _sinit;
+  const uint8_t* end = _data_lma + (_edata - _data_vma);
+  uint32_t crc = 0xFFFFFFFF;
+  while(ptr < end) {
+    crc = (crc >> 4) ^ FACTORY_CRC_table[(crc ^  *ptr      ) & 0x0F];
+    crc = (crc >> 4) ^ FACTORY_CRC_table[(crc ^ (*ptr >> 4)) & 0x0F];
+    ptr++;
+  }
+  return ~crc;
+}
+
+// UID, VDD in mV and firmware hash
+static void FACTORY_info(uint32_t* uid, uint16_t* vdd, uint32_t* hash) {
+  uid[0] = ESIG->ESIG_UNIID1;
+  uid[1] = ESIG->ESIG_UNIID2;
+  uid[2] = ESIG->ESIG_UNIID3;
+  ADC_init();
+  ADC_slow();
+  *vdd = ADC_read_VDD();
+  ADC_disable();
+  *hash = FACTORY_hash();
+}
+
+// Key combination of the test mode (a ladder can't tell two keys apart: KEY8 alone)
+uint8_t FACTORY_keys(void) {
+  #if LADDER_ENABLE > 0
+  return LADDER_read() == LADDER_KEYS;
+  #elif TOUCH_ENABLE > 0
+  return 0;                                   // pads are calibrated untouched
+  #else
+  return !PIN_read(PIN_KEY1) && !PIN_read(PIN_KEY5);
+  #endif
+}
+
+#else
+#define FACTORY_info(uid, vdd, hash)  FACTORY_HOST_info(uid, vdd, hash)
+
+uint8_t FACTORY_keys(void) {
+  return 0;
+}
+#endif  // IR_HOST
+
+// ===================================================================================
+// Test Sequence
+// ===================================================================================
+
+// Carrier burst of 8ms and 2ms pause
+static void FACTORY_burst(void) {
+  IR_start();
+  IR_markTicks(IR_ticks(8000));
+  IR_spaceTicks(IR_ticks(2000));
+}
+
+// Append little endian value of len bytes to the report
+static uint8_t* FACTORY_put(uint8_t* ptr, uint32_t value, uint8_t len) {
+  while(len--) {
+    *ptr++ = value;
+    value >>= 8;
+  }
+  return ptr;
+}
+
+// Send test sequence
+void FACTORY_run(void) {
+  uint8_t  report[FACTORY_REPORT];
+  uint8_t* ptr = report;
+  uint8_t  sum = 0;
+  uint32_t uid[3], hash;
+  uint16_t vdd;
+
+  // Measure before sending (VDD without load of the IR LED)
+  FACTORY_info(uid, &vdd, &hash);
+  *ptr++ = FACTORY_VERSION;
+  for(uint8_t i=0; i<3; i++) ptr = FACTORY_put(ptr, uid[i], 4);
+  ptr = FACTORY_put(ptr, vdd, 2);
+  ptr = FACTORY_put(ptr, hash, 4);
+  for(uint8_t i=0; i<FACTORY_REPORT-1; i++) sum += report[i];
+  *ptr = -sum;
+
+  // Sync
+  IR_carrier(38000);
+  IR_start();
+  IR_markTicks(IR_ticks(9000));
+  IR_spaceTicks(IR_ticks(4500));
+
+  // Carrier frequencies
+  IR_carrier(30000); FACTORY_burst();
+  IR_carrier(33000); FACTORY_burst();
+  IR_carrier(36000); FACTORY_burst();
+  IR_carrier(38000); FACTORY_burst();
+  IR_carrier(40000); FACTORY_burst();
+  IR_carrier(56000); FACTORY_burst();
+
+  // Duty cycles
+  IR_carrierDuty(38000, 10); FACTORY_burst();
+  IR_carrierDuty(38000, 25); FACTORY_burst();
+  IR_carrierDuty(38000, 50); FACTORY_burst();
+
+  // Timing calibration
+  IR_carrier(38000);
+  IR_start();
+  IR_sendEdges(FACTORY_timing, sizeof(FACTORY_timing) / sizeof(uint32_t));
+
+  // Report
+  IR_start();
+  PD_send(&FACTORY_protocol, report, FACTORY_REPORT * 8);
+
+  DBG_print("FACTORY UID "); DBG_printH(uid[0]); DBG_printH(uid[1]); DBG_printH(uid[2]);
+  DBG_print(" VDD ");  DBG_printD(vdd);
+  DBG_print(" HASH "); DBG_printH(hash); DBG_write('\n');
+}
+
+#endif  // FACTORY_ENABLE || IR_HOST
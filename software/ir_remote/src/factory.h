@@ -0,0 +1,78 @@
+// ===================================================================================
+// Factory Test Mode for CH32V003                                             * v1.0 *
+// ===================================================================================
+//
+// If KEY1 and KEY5 are held down at power-up, the remote sends a fixed test sequence
+// for an IR test fixture on the production line and then continues as usual. The
+// sequence takes 270ms after measuring VDD and hashing the firmware (about 30ms), all
+// carriers are generated by the carrier generator selected in config.h:
+//
+// Part         Carrier           Content
+// -----------  ----------------  ---------------------------------------------------
+// sync         38kHz 25%         9ms mark, 4.5ms space (trigger of the fixture)
+// frequencies  30..56kHz 25%     8ms mark, 2ms space each: 30, 33, 36, 38, 40, 56kHz
+// duty cycles  38kHz 10/25/50%   8ms mark, 2ms space each (optical power, LED current)
+// timing       38kHz 25%         marks of 250, 500, 1000, 2000, 4000us, each followed
+//                                by a space of the same length (absolute timing)
+// report       38kHz 25%         FACTORY_REPORT bytes by pulse distance (see below)
+//
+// Report: 4.5ms mark, 2.25ms space, then the bytes LSB first with bit mark 281us,
+// "0" space 281us, "1" space 844us (NEC timing at double speed), 281us stop mark and
+// 10ms space. The bytes are: version (1 byte), UID (ESIG_UNIID1..3, 12 bytes, little
+// endian), VDD in mV (2 bytes), firmware hash (4 bytes), checksum (1 byte, sum of all
+// bytes is 0).
+// The firmware hash is the CRC-32 (as zlib.crc32) of the flash image from address 0
+// to the end of the initialized data, i.e. of bin/ir_remote.bin ("make hash").
+// VDD is measured against the internal reference voltage (1.2V, +/-2.5%).
+//
+// Functions available:
+// --------------------
+// FACTORY_keys()           1: key combination of the test mode is held down
+// FACTORY_run()            send test sequence
+//
+// Notes:
+// ------
+// - The test mode is disabled unless FACTORY_ENABLE is set to "1" in config.h.
+// - With the resistor-ladder keypad (LADDER_ENABLE), KEY8 alone starts the test mode.
+// - With touch keys (TOUCH_ENABLE) the test mode can't be started, the pads are
+//   calibrated untouched at power-up.
+// - The report is also written to the debug output (see src/debug.h).
+// - At 1.5MHz, hashing the flash image takes about 17us per byte (30ms for 1.8kB).
+// - If IR_HOST is defined (host builds), the UID, VDD and firmware hash are taken from
+//   FACTORY_HOST_info(), which has to be provided by the host program (see
+//   sim/ir_check.c).
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <config.h>
+#include <stdint.h>
+
+// ===================================================================================
+// Factory Test Parameters
+// ===================================================================================
+#ifndef FACTORY_ENABLE
+  #define FACTORY_ENABLE  0                   // 1: include factory test mode
+#endif
+#define FACTORY_VERSION   1                   // version of the report format
+#define FACTORY_REPORT    20                  // bytes of the report
+
+// ===================================================================================
+// Factory Test Functions
+// ===================================================================================
+uint8_t FACTORY_keys(void);                   // 1: key combination held down
+void FACTORY_run(void);                       // send test sequence
+
+#ifdef IR_HOST
+// ===================================================================================
+// Unit Information for Host Builds
+// ===================================================================================
+void FACTORY_HOST_info(uint32_t* uid, uint16_t* vdd, uint32_t* hash);
+#endif
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,319 @@
+// ===================================================================================
+// IR Carrier and Modulation Functions for CH32V003                           * v1.4 *
+// ===================================================================================
+
+#include "ir.h"
+
+uint32_t IR_time;                             // time of the previous edge in ticks
+
+#ifdef IR_HOST
+
+// Carrier burst until ticks after the previous edge (host)
+void IR_markTicks(uint32_t ticks) {
+  IR_time += ticks;
+  IR_HOST_edge(1, ticks);
+}
+
+// Pause until ticks after the previous edge (host)
+void IR_spaceTicks(uint32_t ticks) {
+  IR_time += ticks;
+  IR_HOST_edge(0, ticks);
+}
+
+// Header mark until ticks after the previous edge (host)
+void IR_markLead(uint32_t ticks) {
+  IR_markTicks(ticks);
+}
+
+// Send count alternating marks and spaces of edges[] ticks (host)
+void IR_sendEdges(const uint32_t* edges, uint8_t count) {
+  for(uint8_t i=0; i<count; i++) {
+    if(i & 1) IR_spaceTicks(edges[i]);
+    else      IR_markTicks(edges[i]);
+  }
+}
+
+#else
+
+#if IR_GEN == IR_GEN_TIM1
+IR_ASSERT(PIN_LED == PA2, "IR_GEN_TIM1 requires the IR LED on PA2");
+#elif IR_GEN == IR_GEN_SPI
+IR_ASSERT(PIN_LED == PC6, "IR_GEN_SPI requires the IR LED on PC6");
+#endif
+#ifdef PIN_LED2
+IR_ASSERT((PIN_LED >> 3) == (PIN_LED2 >> 3), "PIN_LED2 must be on the same port as PIN_LED");
+#endif
+
+// GPIO port of IR LED(s)
+#define IR_PORT           ((PIN_LED) < PC0 ? GPIOA : (PIN_LED) < PD0 ? GPIOC : GPIOD)
+
+#if IR_GEN != IR_GEN_SPI
+
+// Parameters of bit-bang carrier
+uint8_t  IR_BB_on, IR_BB_off, IR_BB_pad;      // loops of on/off-phase, padding nops
+uint16_t IR_BB_half;                          // half carrier period in ticks
+
+// Pin mask of IR LED(s)
+#ifdef PIN_LED2
+  #define IR_BB_MASK      ((1 << ((PIN_LED) & 7)) | (1 << ((PIN_LED2) & 7)))
+#else
+  #define IR_BB_MASK      (1 << ((PIN_LED) & 7))
+#endif
+
+// Init timer for PWM on PA2 (timer1, channel2 N) or pin(s) for bit-bang
+void IR_init(void) {
+  if(IR_BITBANG) {
+    PORT_enable(PIN_LED);           // enable I/O port of LED pin(s)
+    IR_PORT->BSHR = IR_BB_MASK;  // set LED pin(s) to output high
+    PIN_output(PIN_LED);
+    #ifdef PIN_LED2
+    PIN_output(PIN_LED2);
+    #endif
+    return;
+  }
+  RCC->APB2PCENR |= RCC_IOPAEN      // enable I/O Port A
+                  | RCC_AFIOEN      // enable auxiliary I/O functions
+                  | RCC_TIM1EN;     // enable timer 1 module
+  TIM1->CCER      = TIM_CC2NE;      // enable channel 2N output
+  TIM1->CHCTLR1   = TIM_OC2M;       // set channel 2 PWM mode 2
+  TIM1->BDTR      = TIM_MOE;        // main output enable
+  TIM1->CTLR1     = TIM_ARPE        // enable automatic reload register
+                  | TIM_CEN;        // enable timer
+  PIN_high(PIN_LED);                // set LED pin to output high
+  PIN_output(PIN_LED);
+}
+
+// Set bit-bang carrier parameters (calculated by IR_carrier() at compile time)
+void IR_BB_set(uint8_t on, uint8_t off, uint8_t pad, uint16_t half) {
+  IR_BB_on   = on;
+  IR_BB_off  = off;
+  IR_BB_pad  = pad;
+  IR_BB_half = half;
+}
+
+// Set period and compare value of the PWM carrier. Unchanged values are not written
+// again, as the update event would restart the period of a running mark.
+void IR_TIM_set(uint16_t period, uint16_t cmp) {
+  if(TIM1->ATRLR == period && TIM1->CH2CVR == cmp) return;
+  TIM1->ATRLR  = period;
+  TIM1->CH2CVR = cmp;
+  TIM1->SWEVGR = TIM_UG;
+}
+
+// One carrier period per pass: LED on (BCR), on-phase, LED off (BSHR), off-phase,
+// padding nops, check SysTick. Cycle counts are noted on the right, all instructions
+// are uncompressed and word aligned, so instruction fetch doesn't add any cycles.
+#define IR_BB_LOOP(PAD) __asm__ volatile(                                        \
+  "  .option push                 \n"                                            \
+  "  .option norvc                \n"                                            \
+  "  .balign 4                    \n"                                            \
+  "1: sw   %[mask], 0x14(%[port]) \n"  /* LED on                       1     */  \
+  "  mv   %[cnt], %[on]           \n"  /*                              1     */  \
+  "2: addi %[cnt], %[cnt], -1     \n"  /* on-phase loop                1     */  \
+  "  bnez %[cnt], 2b              \n"  /*                              2 / 1 */  \
+  "  sw   %[mask], 0x10(%[port])  \n"  /* LED off                      1     */  \
+  "  mv   %[cnt], %[off]          \n"  /*                              1     */  \
+  "3: addi %[cnt], %[cnt], -1     \n"  /* off-phase loop               1     */  \
+  "  bnez %[cnt], 3b              \n"  /*                              2 / 1 */  \
+  "  .rept " #PAD "               \n"  /* padding                      1     */  \
+  "  nop                          \n"                                            \
+  "  .endr                        \n"                                            \
+  "  lw   %[cnt], 8(%[stk])       \n"  /* read SysTick counter         2     */  \
+  "  sub  %[cnt], %[cnt], %[end]  \n"  /*                              1     */  \
+  "  bltz %[cnt], 1b              \n"  /* next period until end        2     */  \
+  "  .option pop                  \n"                                            \
+  : [cnt]  "=&r" (cnt)                                                          \
+  : [port] "r" (IR_PORT), [mask] "r" (IR_BB_MASK), [stk] "r" (STK),          \
+    [on]   "r" (IR_BB_on),   [off]  "r" (IR_BB_off),  [end] "r" (end)          \
+  : "memory"                                                                    \
+)
+
+// Send bit-bang carrier until end (rounded to the nearest carrier period)
+void IR_BB_until(uint32_t end) {
+  uint32_t cnt;
+  end -= IR_BB_half;
+  switch(IR_BB_pad) {
+    case 0:  IR_BB_LOOP(0); break;
+    case 1:  IR_BB_LOOP(1); break;
+    default: IR_BB_LOOP(2); break;
+  }
+}
+
+// Send bit-bang carrier for ticks
+void IR_BB_burst(uint32_t ticks) {
+  IR_BB_until(STK->CNT + ticks);
+}
+
+#else
+
+// Bitstream buffer, one 16-bit word per bit of a carrier period = 16 carrier periods
+uint16_t IR_SPI_buffer[IR_SPI_BITS];
+uint8_t  IR_SPI_bits, IR_SPI_on;              // current bits per period, on-phase bits
+
+// Init SPI1 and DMA for bitstream output on PC6 (MOSI)
+void IR_init(void) {
+  RCC->AHBPCENR  |= RCC_DMA1EN;     // enable DMA module
+  RCC->APB2PCENR |= RCC_IOPCEN      // enable I/O Port C
+                  | RCC_AFIOEN      // enable auxiliary I/O functions
+                  | RCC_SPI1EN;     // enable SPI module
+  SPI1->CTLR2     = SPI_CTLR2_TXDMAEN;            // enable TX DMA requests
+  SPI1->CTLR1     = SPI_CTLR1_BIDIMODE            // one line, transmit only
+                  | SPI_CTLR1_BIDIOE
+                  | SPI_CTLR1_DFF                 // 16-bit frames
+                  | SPI_CTLR1_SSM                 // software slave management
+                  | SPI_CTLR1_SSI
+                  | SPI_CTLR1_MSTR                // master mode
+                  | (IR_SPI_BR << 3)              // set baud rate prescaler
+                  | SPI_CTLR1_SPE;                // enable SPI
+  DMA1_Channel3->PADDR = (uint32_t)&SPI1->DATAR;  // SPI1 TX is on DMA channel 3
+  DMA1_Channel3->MADDR = (uint32_t)IR_SPI_buffer;
+  IR_SPI_set(1, 0);                 // idle bitstream: LED off
+  PIN_high(PIN_LED);                // set LED pin to output high
+  PIN_output(PIN_LED);
+}
+
+// Fill bitstream buffer with 16 carrier periods of "bits" bits each, of which the
+// first "on" bits switch on the LED (active low), and restart the circular DMA. An
+// unchanged carrier is kept running, so a mark in progress isn't interrupted.
+void IR_SPI_set(uint8_t bits, uint8_t on) {
+  uint8_t phase = 0;
+  if(bits == IR_SPI_bits && on == IR_SPI_on) return;
+  IR_SPI_bits = bits;
+  IR_SPI_on   = on;
+  DMA1_Channel3->CFGR = 0;                        // stop DMA
+  for(uint8_t i=0; i<bits; i++) {
+    uint16_t word = 0;
+    for(uint8_t b=16; b; b--) {                   // MSB is sent first
+      word <<= 1;
+      if(phase >= on) word |= 1;                  // LED off outside the on-phase
+      if(++phase == bits) phase = 0;
+    }
+    IR_SPI_buffer[i] = word;
+  }
+  DMA1_Channel3->CNTR = bits;                     // words per circle
+  DMA1_Channel3->CFGR = DMA_CFGR1_MSIZE_0         // 16-bit memory
+                      | DMA_CFGR1_PSIZE_0         // 16-bit peripheral
+                      | DMA_CFGR1_MINC            // increment memory address
+                      | DMA_CFGR1_CIRC            // circular mode
+                      | DMA_CFGR1_DIR             // memory to peripheral
+                      | DMA_CFGR1_EN;             // enable DMA
+}
+
+#endif  // IR_GEN
+
+// Carrier burst until ticks after the previous edge
+void IR_markTicks(uint32_t ticks) {
+  IR_time += ticks;
+  if(IR_BITBANG) {
+    IR_BB_until(IR_time);
+    return;
+  }
+  IR_on();
+  DLY_until(IR_time);
+}
+
+// Pause until ticks after the previous edge
+void IR_spaceTicks(uint32_t ticks) {
+  IR_off();
+  IR_time += ticks;
+  DLY_until(IR_time);
+}
+
+// ===================================================================================
+// Speculative Header
+// ===================================================================================
+uint8_t  IR_lead;                             // state of the speculative header
+uint32_t IR_leadTime;                         // time of IR_leadStart() / IR_leadArm()
+uint32_t IR_leadCarrier;                      // carrier settings of the header mark
+
+// Current carrier settings as one word (0 with IR_GEN_BITBANG: no speculative header)
+#if IR_GEN == IR_GEN_SPI
+  #define IR_carrierNow() (((uint32_t)IR_SPI_bits << 8) | IR_SPI_on)
+#else
+  #define IR_carrierNow() (IR_BITBANG ? 0 : ((uint32_t)TIM1->ATRLR << 16) \
+                                            | (uint16_t)TIM1->CH2CVR)
+#endif
+
+// Set carrier of a header mark (from IR_leadEnd()) and switch it on before the action
+// of the key is known
+void IR_leadStart(uint32_t carrier) {
+  if(IR_BITBANG) return;                      // bit-bang carrier needs the CPU
+  #if IR_GEN == IR_GEN_SPI
+  IR_SPI_set(carrier >> 8, carrier);
+  #else
+  IR_TIM_set(carrier >> 16, carrier);
+  #endif
+  IR_on();
+  IR_leadTime = STK->CNT;
+  IR_lead     = IR_LEAD_RUN;
+}
+
+// Switch off speculative header (bounce or glitch) and keep LED off for a while
+void IR_leadAbort(void) {
+  if(IR_lead != IR_LEAD_RUN) return;
+  IR_off();
+  IR_lead = IR_LEAD_OFF;
+  DLY_ms(IR_LEAD_GUARD);
+}
+
+// Arm detection of a header mark as first edge of the action
+void IR_leadArm(void) {
+  if(IR_lead == IR_LEAD_RUN) return;          // header is already running
+  IR_leadTime = STK->CNT;
+  IR_lead     = IR_LEAD_ARMED;
+}
+
+// End of action, returns the carrier settings if it started with a header mark of
+// IR_LEAD_MIN or more, else 0
+uint32_t IR_leadEnd(void) {
+  uint32_t carrier = (IR_lead == IR_LEAD_USED) ? IR_leadCarrier : 0;
+  if(IR_lead == IR_LEAD_RUN) IR_off();        // header wasn't taken over
+  IR_lead = IR_LEAD_OFF;
+  return carrier;
+}
+
+// Header mark until ticks after the previous edge. If the carrier was switched on by
+// IR_leadStart(), the mark started there.
+void IR_markLead(uint32_t ticks) {
+  if(IR_lead == IR_LEAD_RUN) {                // header started on the wake edge
+    IR_time = IR_leadTime;
+    IR_lead = IR_LEAD_USED;
+  }
+  else if(IR_lead == IR_LEAD_ARMED) {         // first edge of the action?
+    IR_lead = (ticks >= IR_LEAD_MIN
+           && (uint32_t)(STK->CNT - IR_leadTime) < IR_LEAD_WINDOW)
+            ? IR_LEAD_USED : IR_LEAD_OFF;
+  }
+  IR_leadCarrier = IR_carrierNow();           // carrier the encoder has set
+  IR_markTicks(ticks);
+}
+
+// Send count alternating marks and spaces of edges[] ticks, starting with a mark at
+// IR_time. The port configurations for carrier on/off are calculated in advance and
+// the next deadline is prepared before waiting, so after each deadline there is only
+// the SysTick poll (5 cycles) and a single store until the edge is switched.
+void IR_sendEdges(const uint32_t* edges, uint8_t count) {
+  if(IR_BITBANG) {                            // carrier is generated within the marks
+    for(uint8_t i=0; i<count; i++) {
+      if(i & 1) IR_spaceTicks(edges[i]);
+      else      IR_markTicks(edges[i]);
+    }
+    return;
+  }
+  uint32_t cfg  = IR_PORT->CFGLR & ~((uint32_t)0b1111 << ((PIN_LED & 7) << 2));
+  uint32_t on   = cfg | ((uint32_t)0b1001 << ((PIN_LED & 7) << 2));  // alternate output
+  uint32_t off  = cfg | ((uint32_t)0b0001 << ((PIN_LED & 7) << 2));  // output HIGH
+  uint32_t next = on;
+  uint32_t time = IR_time;
+  while(count--) {
+    while((int32_t)(STK->CNT - time) < 0);    // wait for deadline
+    IR_PORT->CFGLR = next;                    // switch edge
+    time += *edges++;                         // prepare next edge
+    next ^= on ^ off;
+  }
+  while((int32_t)(STK->CNT - time) < 0);      // wait for end of last edge
+  IR_PORT->CFGLR = off;
+  IR_time = time;
+}
+
+#endif  // IR_HOST
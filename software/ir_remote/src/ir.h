@@ -0,0 +1,281 @@
+// ===================================================================================
+// IR Carrier and Modulation Functions for CH32V003                           * v1.4 *
+// ===================================================================================
+//
+// The carrier frequency with a duty cycle of 25% is generated by one of the following
+// carrier generators (select with IR_GEN in config.h):
+//
+// IR_GEN_AUTO:    Timer1 if the IR LED is on PA2 and there is no second LED, bit-bang
+//                 otherwise. This is the default.
+// IR_GEN_TIM1:    Timer1 generates the carrier as PWM on the IR LED pin (PA2, timer1
+//                 channel 2N).
+// IR_GEN_SPI:     SPI1 continuously clocks out a precomputed carrier bitstream on MOSI
+//                 (PC6), fed by DMA1 channel 3 in circular mode. Works without any
+//                 timer, so TIM1 and TIM2 stay free for other purposes.
+// IR_GEN_BITBANG: A calibrated assembly loop toggles the LED pin(s) by BCR/BSHR writes
+//                 during each mark. Works on any pin and drives an optional second IR
+//                 LED (PIN_LED2, same port as PIN_LED) in parallel.
+//
+// With timer1 and SPI the signal is modulated by switching the pin between alternate
+// output (carrier, LED modulated) and output HIGH (LED off, active low).
+//
+// Functions available:
+// --------------------
+// IR_init()                init carrier generator and IR LED pin(s)
+// IR_carrier(freq)         set carrier frequency in Hertz (25% duty cycle)
+// IR_carrierDuty(freq, d)  set carrier frequency in Hertz and duty cycle in percent
+// IR_on()                  switch on carrier output (LED modulated, not bit-bang)
+// IR_off()                 switch off carrier output (LED off)
+// IR_mark(us)              send carrier burst for us microseconds
+// IR_space(us)             pause for us microseconds
+// IR_pause(ms)             pause for ms milliseconds (e.g. between repeats)
+//
+// IR_ticks(us)             convert microseconds (may be fractional) into system ticks
+// IR_start()               start a sequence of edges at the current time
+// IR_markTicks(ticks)      send carrier burst until ticks after the previous edge
+// IR_spaceTicks(ticks)     pause until ticks after the previous edge
+// IR_sendEdges(edges, n)   send n alternating marks/spaces of edges[] ticks
+// IR_time                  time of the previous edge in system ticks
+//
+// IR_markLead(ticks)       header mark, may have been started by IR_leadStart()
+// IR_leadStart(carrier)    set carrier, switch it on before the action is known
+// IR_leadAbort()           switch off speculative header, pause IR_LEAD_GUARD ms
+// IR_leadArm()             arm detection of a header as first edge of an action
+// IR_leadEnd()             end of action, carrier of its header mark (0: none)
+//
+// Notes:
+// ------
+// - The IR LED pin is defined as PIN_LED in config.h, an optional second IR LED as
+//   PIN_LED2 (bit-bang only).
+// - IR_GEN_SPI: The bitstream buffer holds 16 carrier periods in one 16-bit word per
+//   bit of a period (SPI clock IR_SPI_FREQ, ~1MHz). Its size is fixed by the lowest
+//   supported carrier (30kHz) and costs 2 * IR_SPI_BITS bytes of SRAM, i.e. 52 bytes
+//   at F_CPU = 1.5MHz. The protocols use 19 (SIRC), 20 (NEC, Samsung) and 21 (RC-5)
+//   words of it. The carrier frequency is rounded to F_SPI / n, at 1.5MHz this is
+//   37.5kHz (NEC, Samsung), 35.7kHz (RC-5) and 39.5kHz (SIRC). A complete frame
+//   (carrier and envelope) as bitstream would need 2.3kB (RC-5) to 6.3kB (NEC), so
+//   only the carrier is streamed and the envelope is done by switching the pin.
+// - IR_GEN_BITBANG: The on-phase of a carrier period takes 3*on+1 cycles, the off-phase
+//   3*off+6+pad cycles (pad = 0..2 nops), so every period length from IR_BB_CYC_MIN
+//   (13) cycles upwards is met exactly. This assumes the QingKe V2A timing without
+//   flash wait states (F_CPU <= 24MHz): 1 cycle per ALU/store instruction, 2 cycles
+//   per load and taken branch (CYC_* in system.h). IR_carrier() checks at compile
+//   time that the carrier fits into this budget. At 1.5MHz the periods are 39 cycles
+//   (38.5kHz, NEC, Samsung), 42 cycles (35.7kHz, RC-5) and 38 cycles (39.5kHz, SIRC),
+//   each with a 10 cycle on-phase. A mark ends with the carrier period closest to its
+//   nominal length (checked on SysTick once per period). Interrupts during a mark
+//   stretch the carrier, so keep them disabled while sending (none are used by this
+//   firmware).
+// - Use IR_mark() and IR_space() with constant values only, so that the conversion
+//   into system ticks is done by the compiler (there is no hardware multiplier).
+// - IR_markTicks() and IR_spaceTicks() wait for absolute deadlines on SysTick. Each
+//   edge is switched with the same latency after its deadline, so the execution time
+//   between the calls (loops, table lookups) doesn't change the length of marks and
+//   spaces, as long as it is shorter than the mark or space. The tick values can be
+//   calculated by IR_ticks() at compile time and stored in protocol descriptors.
+// - IR_sendEdges() sends a frame expanded into a list of ticks in advance. Nothing is
+//   calculated between a deadline and its edge, which keeps the jitter within the
+//   SysTick poll loop (5 cycles, 3.3us at 1.5MHz). This is meant for protocols with
+//   short marks and spaces (e.g. RC-MM, XMP). With IR_GEN_BITBANG the edges are sent
+//   by IR_markTicks() and IR_spaceTicks().
+// - Speculative header: the application can switch on the carrier by IR_leadStart()
+//   as soon as a key press wakes it up, and debounce the key while the carrier runs.
+//   If the encoder then sends its header by IR_markLead(), the mark is counted from
+//   IR_leadStart(), so the debounce time doesn't delay the frame. If the press was a
+//   bounce, IR_leadAbort() ends the burst, which is far too short for a header, and
+//   keeps the LED off for IR_LEAD_GUARD ms so that it isn't merged with the next
+//   frame. Whether the action of a key starts with a header is learned from its
+//   previous press: IR_leadArm() before and IR_leadEnd() after the action tell
+//   whether IR_markLead() came as its first edge with at least IR_LEAD_MIN ticks.
+//   IR_leadEnd() returns the carrier settings of that header, which the application
+//   keeps per key and passes to IR_leadStart(), so the header starts at the carrier
+//   frequency of the encoder. IR_carrier() does nothing if frequency and duty cycle
+//   are unchanged, so it doesn't restart the timer period or the DMA bitstream of the
+//   running header. Not with IR_GEN_BITBANG, whose carrier needs the CPU.
+// - If IR_HOST is defined (host builds), the modulation functions don't touch any
+//   hardware but pass each mark and space in system ticks to IR_HOST_edge(), which
+//   has to be provided by the host program. IR_carrier() calls IR_HOST_carrier().
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <config.h>
+#include "system.h"
+#include "gpio.h"
+
+#ifdef IR_HOST
+// ===================================================================================
+// Recording Backend for Host Builds
+// ===================================================================================
+void IR_HOST_carrier(uint32_t freq);          // carrier frequency has changed
+void IR_HOST_edge(uint8_t mark, uint32_t ticks);  // mark (1) or space (0) of ticks
+#define IR_start()
+
+#define IR_init()
+#define IR_carrier(freq)  IR_HOST_carrier(freq)
+#define IR_carrierDuty(freq, duty)  IR_HOST_carrier(freq)
+#define IR_on()
+#define IR_off()
+#define IR_mark(us)       IR_HOST_edge(1, IR_ticks(us))
+#define IR_space(us)      IR_HOST_edge(0, IR_ticks(us))
+#define IR_pause(ms)      IR_HOST_edge(0, (ms) * DLY_MS_TIME)
+
+#else
+// ===================================================================================
+// Carrier Generator Selection
+// ===================================================================================
+#define IR_GEN_AUTO       0                   // timer1 on PA2, bit-bang otherwise
+#define IR_GEN_TIM1       1                   // timer1 PWM on PA2
+#define IR_GEN_SPI        2                   // SPI1 + DMA bitstream on PC6
+#define IR_GEN_BITBANG    3                   // assembly loop on any pin(s)
+
+#ifndef IR_GEN
+  #define IR_GEN          IR_GEN_AUTO
+#endif
+
+// Pins are enums and can't be compared by the preprocessor, so the automatic selection
+// is a constant expression, which lets the compiler drop the unused path.
+#if   IR_GEN == IR_GEN_BITBANG || (IR_GEN == IR_GEN_AUTO && defined(PIN_LED2))
+  #define IR_BITBANG      1
+#elif IR_GEN == IR_GEN_AUTO
+  #define IR_BITBANG      (PIN_LED != PA2)
+#elif IR_GEN == IR_GEN_TIM1 || IR_GEN == IR_GEN_SPI
+  #define IR_BITBANG      0
+#else
+  #error Unknown carrier generator IR_GEN
+#endif
+
+#ifdef __cplusplus
+  #define IR_ASSERT       static_assert
+#else
+  #define IR_ASSERT       _Static_assert
+#endif
+
+// ===================================================================================
+// Carrier Functions
+// ===================================================================================
+void IR_init(void);                           // init carrier generator and IR LED pin
+void IR_BB_burst(uint32_t ticks);             // send bit-bang carrier for ticks
+void IR_BB_until(uint32_t end);               // send bit-bang carrier until end
+
+#if IR_GEN == IR_GEN_SPI
+
+// SPI clock prescaler (SPI clock ~1MHz)
+#if   F_CPU <=  2000000
+  #define IR_SPI_BR       0                   // F_CPU / 2
+#elif F_CPU <=  4000000
+  #define IR_SPI_BR       1                   // F_CPU / 4
+#elif F_CPU <=  8000000
+  #define IR_SPI_BR       2                   // F_CPU / 8
+#elif F_CPU <= 16000000
+  #define IR_SPI_BR       3                   // F_CPU / 16
+#elif F_CPU <= 32000000
+  #define IR_SPI_BR       4                   // F_CPU / 32
+#else
+  #define IR_SPI_BR       5                   // F_CPU / 64
+#endif
+#define IR_SPI_FREQ       (F_CPU >> (IR_SPI_BR + 1))  // SPI bit rate
+#define IR_SPI_BITS       (IR_SPI_FREQ / 30000 + 1)   // max bits per carrier period
+
+void IR_SPI_set(uint8_t bits, uint8_t on);    // fill bitstream buffer if changed
+
+// Set carrier frequency and duty cycle in percent
+#define IR_carrierDuty(freq, duty)                                              \
+  IR_SPI_set((IR_SPI_FREQ + (freq) / 2) / (freq),                               \
+             (IR_SPI_FREQ * (duty) + (freq) * 50) / ((freq) * 100))
+
+#else
+
+// Cycle budget of the bit-bang loop (see notes above)
+#if IR_BITBANG && F_CPU > 24000000
+  #error IR_GEN_BITBANG is calibrated for F_CPU <= 24MHz (no flash wait states)
+#endif
+// On-phase: sw, mv and the last bnez not taken. Off-phase: the same plus SysTick check.
+#define IR_BB_CYC_LOOP    (CYC_ALU + CYC_JUMP)                  // addi, bnez per loop
+#define IR_BB_CYC_ON      (3 * CYC_ALU - CYC_JUMP)              // fixed on-phase cycles
+#define IR_BB_CYC_OFF     (IR_BB_CYC_ON + CYC_LOAD + CYC_ALU + CYC_JUMP) // off-phase
+#define IR_BB_CYC_MIN     (IR_BB_CYC_ON + IR_BB_CYC_OFF + 2 * IR_BB_CYC_LOOP)
+
+#define IR_BB_PERIOD(f)   ((F_CPU + (f) / 2) / (f))   // cycles per carrier period
+#define IR_BB_DUTY(f, d)  ((IR_BB_PERIOD(f) * (d) / 100 - IR_BB_CYC_ON              \
+                          + IR_BB_CYC_LOOP / 2) / IR_BB_CYC_LOOP) // loops for d%
+#define IR_BB_ON(f, d)    (IR_BB_DUTY(f, d) ? IR_BB_DUTY(f, d) : 1) // loops of on-phase
+#define IR_BB_REST(f, d)  (IR_BB_PERIOD(f) - IR_BB_CYC_ON - IR_BB_CYC_OFF \
+                          - IR_BB_ON(f, d) * IR_BB_CYC_LOOP)
+
+void IR_BB_set(uint8_t on, uint8_t off, uint8_t pad, uint16_t half);
+void IR_TIM_set(uint16_t period, uint16_t cmp);  // set PWM carrier if changed
+
+// Set carrier frequency and duty cycle in percent
+#define IR_carrierDuty(freq, duty) {                                            \
+  IR_ASSERT(!IR_BITBANG || IR_BB_REST(freq, duty) >= IR_BB_CYC_LOOP,            \
+            "carrier frequency or duty cycle too high for IR_GEN_BITBANG");     \
+  if(IR_BITBANG) {                                                              \
+    IR_BB_set(IR_BB_ON(freq, duty), IR_BB_REST(freq, duty) / IR_BB_CYC_LOOP,    \
+              IR_BB_REST(freq, duty) % IR_BB_CYC_LOOP, IR_BB_PERIOD(freq) / 2); \
+  }                                                                             \
+  else {                                                                        \
+    IR_TIM_set(F_CPU / (freq) - 1, F_CPU / (freq) * (duty) / 100 + 1);          \
+  }                                                                             \
+}
+
+#endif  // IR_GEN
+
+// Set carrier frequency and 25% duty cycle
+#define IR_carrier(freq)  IR_carrierDuty(freq, 25)
+
+// Start a sequence of edges
+#define IR_start()        (IR_time = STK->CNT)
+
+// Switch carrier output on/off (the bit-bang carrier runs only within IR_mark())
+#define IR_on()           {if(!IR_BITBANG) PIN_alternate(PIN_LED);} // output carrier
+#define IR_off()          {if(!IR_BITBANG) PIN_output(PIN_LED);}    // output HIGH
+
+// ===================================================================================
+// Modulation Functions
+// ===================================================================================
+// Carrier burst
+#define IR_mark(us) {                                                           \
+  if(IR_BITBANG) IR_BB_burst(IR_ticks(us));                                     \
+  else {IR_on(); DLY_us(us);}                                                   \
+}
+#define IR_space(us)      {IR_off(); DLY_us(us);} // pause
+#define IR_pause(ms)      {IR_off(); DLY_ms(ms);} // pause (LED off)
+
+#endif  // IR_HOST
+
+// ===================================================================================
+// Edge Functions (absolute timing)
+// ===================================================================================
+#define IR_ticks(us)      ((uint32_t)((us) * (F_CPU / 1000000.0) + 0.5))
+
+extern uint32_t IR_time;                      // time of the previous edge
+void IR_markTicks(uint32_t ticks);            // carrier burst until IR_time + ticks
+void IR_spaceTicks(uint32_t ticks);           // pause until IR_time + ticks
+void IR_sendEdges(const uint32_t* edges, uint8_t count);  // marks/spaces, mark first
+void IR_markLead(uint32_t ticks);             // header mark until IR_time + ticks
+
+// ===================================================================================
+// Speculative Header
+// ===================================================================================
+#define IR_LEAD_OFF       0                   // no speculative header
+#define IR_LEAD_ARMED     1                   // action started, no edge sent yet
+#define IR_LEAD_RUN       2                   // carrier switched on by IR_leadStart()
+#define IR_LEAD_USED      3                   // action started with a header mark
+#define IR_LEAD_MIN       IR_ticks(2000)      // shortest header mark to start early
+#define IR_LEAD_WINDOW    IR_ticks(500)       // header within this after IR_leadArm()
+#define IR_LEAD_GUARD     10                  // LED off after an aborted header in ms
+
+extern uint8_t  IR_lead;                      // state of the speculative header
+extern uint32_t IR_leadTime;                  // time of IR_leadStart() / IR_leadArm()
+void IR_leadStart(uint32_t carrier);          // switch on carrier for a header
+void IR_leadAbort(void);                      // switch off speculative header
+void IR_leadArm(void);                        // arm detection of a leading header
+uint32_t IR_leadEnd(void);                    // end of action, carrier of header or 0
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,72 @@
+// ===================================================================================
+// Resistor-Ladder Keypad on a Single ADC Pin for CH32V003                    * v1.0 *
+// ===================================================================================
+
+#include "ladder.h"
+
+#if LADDER_ENABLE > 0 || defined(LADDER_HOST)
+
+// Upper limits of the ADC values of the keys: halfway to the next level, the last one
+// half a step above the level of KEY8
+#define LADDER_MID(a, b)  ((uint16_t)((LADDER_LEVEL(a) + LADDER_LEVEL(b)) / 2))
+
+static const uint16_t LADDER_limit[LADDER_KEYS] = {
+  LADDER_MID(LADDER_R1, LADDER_R2), LADDER_MID(LADDER_R2, LADDER_R3),
+  LADDER_MID(LADDER_R3, LADDER_R4), LADDER_MID(LADDER_R4, LADDER_R5),
+  LADDER_MID(LADDER_R5, LADDER_R6), LADDER_MID(LADDER_R6, LADDER_R7),
+  LADDER_MID(LADDER_R7, LADDER_R8),
+  (uint16_t)(LADDER_LEVEL(LADDER_R8) + (LADDER_LEVEL(LADDER_R8) - LADDER_LEVEL(LADDER_R7)) / 2)
+};
+
+_Static_assert(LADDER_LEVEL(LADDER_R8) < 1023 / 4, "ladder levels must be below VDD/4");
+
+// Number of key for ADC value (0: none)
+uint8_t LADDER_decode(uint16_t value) {
+  for(uint8_t key=0; key<LADDER_KEYS; key++) {
+    if(value < LADDER_limit[key]) return key + 1;
+  }
+  return 0;
+}
+
+#ifndef LADDER_HOST
+// ===================================================================================
+// Ladder Pin and ADC
+// ===================================================================================
+#include "system.h"
+#include "gpio.h"
+
+// Init ladder pin (external pullup, event on falling edge) and ADC (powered down)
+void LADDER_init(void) {
+  PIN_input(PIN_LADDER);
+  PIN_EVT_set(PIN_LADDER, PIN_EVT_FALLING);   // key press wakes up from standby
+  ADC_init();
+  ADC_fast();
+  ADC_input(PIN_LADDER);
+  ADC_disable();
+}
+
+// Scan keypad, returns number of pressed key (0: none)
+uint8_t LADDER_read(void) {
+  uint16_t value;
+  PIN_input_AN(PIN_LADDER);                   // no Schmitt trigger current at mid level
+  ADC_enable();
+  DLY_us(LADDER_SETTLE);
+  value = ADC_read();
+  ADC_disable();
+  PIN_input(PIN_LADDER);
+  return LADDER_decode(value);
+}
+
+#else
+// ===================================================================================
+// Host Backend
+// ===================================================================================
+void LADDER_init(void) {
+}
+
+uint8_t LADDER_read(void) {
+  return LADDER_decode(LADDER_HOST_adc());
+}
+#endif  // LADDER_HOST
+
+#endif  // LADDER_ENABLE || LADDER_HOST
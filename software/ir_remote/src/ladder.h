@@ -0,0 +1,97 @@
+// ===================================================================================
+// Resistor-Ladder Keypad on a Single ADC Pin for CH32V003                    * v1.0 *
+// ===================================================================================
+//
+// Reads up to 8 keys on one pin, so that the 8-pin package (CH32V003J4M6) has pins
+// left for other functions. An external resistor R0 pulls the pin up to VDD, each key
+// connects the pin to GND through its own resistor Rn:
+//
+//   VDD --[R0 10k]--+------+------+-- ... --+---- PIN_LADDER
+//                   |      |      |         |
+//                 KEY1   KEY2   KEY3  ...  KEY8
+//                   |      |      |         |
+//                  [R1]   [R2]   [R3]      [R8]
+//                   |      |      |         |
+//   GND ------------+------+------+-- ... --+
+//
+// Key   R1  R2    R3    R4    R5    R6    R7    R8
+// Rn    0   330   680   1.1k  1.5k  2.0k  2.4k  3.0k
+// ADC   0   33    65    101   133   170   198   236   (idle: 1023)
+//
+// The ADC uses VDD as reference, so the reading of the divider R0/Rn doesn't depend on
+// VDD: the levels are fractions of VDD and stay put while the battery drains, no
+// calibration is needed. All levels are below a quarter of VDD, i.e. below the input
+// low level of the pin, so each key press causes a falling edge on PIN_LADDER, which
+// wakes the MCU from standby by a pin event just like the direct keys. Standby current
+// is the same as with direct keys (no current flows while all keys are open, the ADC
+// is off). While a key is held, VDD / (R0 + Rn) flows (300uA at 3V for KEY1, about
+// 3.5 times the internal pullup of a direct key).
+//
+// A scan switches the pin to analog input, powers up the ADC, converts once in fast
+// mode and powers the ADC down again: about 120us at 1.5MHz, compared to about 17us
+// for reading five key pins. The simulator sim/ladder_sim.c compares both and checks
+// the levels against resistor tolerance and ADC errors over the VDD range.
+//
+// Functions available:
+// --------------------
+// LADDER_init()            init ladder pin (pin event on falling edge) and ADC
+// LADDER_read()            scan keypad, returns number of pressed key (0: none)
+// LADDER_decode(value)     number of key for ADC value (0: none)
+//
+// Notes:
+// ------
+// - The ladder is disabled unless LADDER_ENABLE is set to "1" in config.h, the keys
+//   KEY1..KEY8 are then read from PIN_LADDER instead of PIN_KEY1..PIN_KEY5.
+// - PIN_LADDER must be an ADC input: PA1, PA2, PC4, PD2, PD3, PD4, PD5 or PD6.
+// - Use resistors of 1% tolerance. If two keys are pressed at once, the parallel
+//   resistance reads as the lower key (KEY1 wins over all others).
+// - If LADDER_HOST is defined (host builds), the ADC is replaced by LADDER_HOST_adc(),
+//   which has to be provided by the host program (see sim/ladder_sim.c).
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <config.h>
+#include <stdint.h>
+
+// ===================================================================================
+// Ladder Parameters
+// ===================================================================================
+#ifndef LADDER_ENABLE
+  #define LADDER_ENABLE   0                   // 1: keys on a resistor ladder
+#endif
+#define LADDER_KEYS       8                   // number of keys
+#define LADDER_R0         10000               // pullup resistor in ohms
+#define LADDER_R1         0                   // key resistors in ohms
+#define LADDER_R2         330
+#define LADDER_R3         680
+#define LADDER_R4         1100
+#define LADDER_R5         1500
+#define LADDER_R6         2000
+#define LADDER_R7         2400
+#define LADDER_R8         3000
+#define LADDER_SETTLE     10                  // ADC power-up time in us
+
+// ADC value of the divider with key resistor r
+#define LADDER_LEVEL(r)   (1023.0 * (r) / (LADDER_R0 + (r)))
+
+// ===================================================================================
+// Ladder Functions
+// ===================================================================================
+void LADDER_init(void);                       // init ladder pin and ADC
+uint8_t LADDER_read(void);                    // scan keypad, returns key (0: none)
+uint8_t LADDER_decode(uint16_t value);        // key for ADC value (0: none)
+
+#ifdef LADDER_HOST
+// ===================================================================================
+// ADC Backend for Host Builds
+// ===================================================================================
+uint16_t LADDER_HOST_adc(void);               // ADC value of the ladder pin
+#endif
+
+#ifdef __cplusplus
+};
+#endif
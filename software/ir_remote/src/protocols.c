@@ -0,0 +1,611 @@
+// ===================================================================================
+// IR Protocol Encoders                                                       * v1.3 *
+// ===================================================================================
+//
+// The encoders only use the modulation and edge functions of ir.h (IR_carrier,
+// IR_mark, IR_space, IR_pause, IR_markTicks, ...) and KEY_read() of the application.
+// This allows them to be linked against another modulation backend, e.g. one that
+// records the generated marks and spaces on a host computer (see IR_HOST in ir.h and
+// the golden timing vectors in sim/ir_golden.c).
+
+#include "protocols.h"
+
+// ===================================================================================
+// Pulse Distance Encoder
+// ===================================================================================
+//
+// Sends header, bits and stop mark of a pulse distance protocol as described by a
+// PD_protocol_t. Every bit is a mark of the same length followed by a space whose
+// length depends on the bit. The edges are switched at absolute deadlines, so the
+// time needed to fetch the next bit doesn't add to the timing. The caller sets the
+// carrier frequency and calls IR_start() before the first frame of a sequence.
+
+// Send bits of data (bytes in order, bits of each byte as given by flags)
+void PD_send(const PD_protocol_t* proto, const uint8_t* data, uint8_t bits) {
+  uint8_t mask = (proto->flags & PD_MSB_FIRST) ? 0x80 : 0x01;
+  if(proto->hdrMark) {                        // header (may have started early)
+    IR_markLead(proto->hdrMark);
+    IR_spaceTicks(proto->hdrSpace);
+  }
+  for(uint8_t bit=mask; bits; bits--) {       // bits
+    IR_markTicks(proto->bitMark);
+    IR_spaceTicks((*data & bit) ? proto->oneSpace : proto->zeroSpace);
+    bit = (mask & 0x80) ? (bit >> 1) : (bit << 1);
+    if(!bit) {                                // next byte
+      bit = mask;
+      data++;
+    }
+  }
+  if(proto->stopMark) {                       // stop mark
+    IR_markTicks(proto->stopMark);
+    IR_spaceTicks(proto->stopSpace);
+  }
+}
+
+#if USE_NEC > 0 || USE_SAM > 0
+// ===================================================================================
+// NEC Protocol Implementation
+// ===================================================================================
+//
+// The NEC protocol uses pulse distance modulation.
+//
+//       +---------+     +-+ +-+   +-+   +-+ +-    ON
+//       |         |     | | | |   | |   | | |          bit0:  562.5us
+//       |   9ms   |4.5ms| |0| | 1 | | 1 | |0| ...
+//       |         |     | | | |   | |   | | |          bit1: 1687.5us
+// ------+         +-----+ +-+ +---+ +---+ +-+     OFF
+//
+// IR telegram starts with a 9ms leading burst followed by a 4.5ms pause.
+// Afterwards 4 data bytes are transmitted, least significant bit first.
+// A "0" bit is a 562.5us burst followed by a 562.5us pause, a "1" bit is
+// a 562.5us burst followed by a 1687.5us pause. A final 562.5us burst
+// signifies the end of the transmission. The four data bytes are in order:
+// - the 8-bit address for the receiving device,
+// - the 8-bit logical inverse of the address,
+// - the 8-bit command and
+// - the 8-bit logical inverse of the command.
+// The Extended NEC protocol uses 16-bit addresses. Instead of sending an
+// 8-bit address and its logically inverse, first the low byte and then the
+// high byte of the address is transmitted.
+//
+// If the key on the remote controller is kept depressed, a repeat code
+// will be issued consisting of a 9ms leading burst, a 2.25ms pause and
+// a 562.5us burst to mark the end. The repeat code will continue to be
+// sent out at 108ms intervals, until the key is finally released.
+
+// Define carrier frequency in Hertz
+#define NEC_FREQ            38000
+
+// Timings in system ticks (spec values), shared with the Samsung protocol
+#define NEC_UNIT            IR_ticks(562.5)         // mark, "0" space
+#define NEC_ONE             IR_ticks(1687.5)        // "1" space
+
+#if USE_NEC > 0
+static const PD_protocol_t NEC_protocol = {
+  .hdrMark   = IR_ticks(9000),
+  .hdrSpace  = IR_ticks(4500),
+  .bitMark   = NEC_UNIT,
+  .zeroSpace = NEC_UNIT,
+  .oneSpace  = NEC_ONE,
+  .stopMark  = NEC_UNIT,
+  .stopSpace = NEC_UNIT,
+  .flags     = PD_LSB_FIRST
+};
+
+static const PD_protocol_t NEC_repeat = {             // repeat code: no bits
+  .hdrMark   = IR_ticks(9000),
+  .hdrSpace  = IR_ticks(2250),
+  .stopMark  = NEC_UNIT,
+  .stopSpace = NEC_UNIT,
+  .flags     = PD_LSB_FIRST
+};
+
+// Send complete telegram (start frame + address + command) via IR
+void NEC_sendCode(uint16_t addr, uint8_t cmd) {
+  uint8_t data[4] = {addr, addr >> 8, cmd, ~cmd};
+  if(addr <= 0xff) data[1] = ~addr;           // standard NEC: inverse of address byte
+
+  // Prepare carrier wave
+  IR_carrier(NEC_FREQ);                       // set PWM frequency and duty cycle
+
+  // Send telegram
+  IR_start();
+  PD_send(&NEC_protocol, data, 32);           // header, 32 bits, end mark
+  while(KEY_read()) {                         // repeat code until button is released
+    IR_pause(40);
+    IR_start();
+    PD_send(&NEC_repeat, data, 0);            // 9ms burst, 2.25ms pause, end mark
+    IR_pause(56);
+  }
+}
+#endif  // USE_NEC > 0
+#endif  // USE_NEC > 0 || USE_SAM > 0
+
+#if USE_SAM > 0
+// ===================================================================================
+// SAMSUNG Protocol Implementation
+// ===================================================================================
+//
+// The SAMSUNG protocol corresponds to the NEC protocol, except that the start pulse is
+// 4.5ms long and the address byte is sent twice. The telegram is repeated every 108ms
+// as long as the button is pressed.
+
+static const PD_protocol_t SAM_protocol = {
+  .hdrMark   = IR_ticks(4500),
+  .hdrSpace  = IR_ticks(4500),
+  .bitMark   = NEC_UNIT,
+  .zeroSpace = NEC_UNIT,
+  .oneSpace  = NEC_ONE,
+  .stopMark  = NEC_UNIT,
+  .stopSpace = NEC_UNIT,
+  .flags     = PD_LSB_FIRST
+};
+#define SAM_repeatPause()   IR_pause(44)
+
+// Send complete telegram (start frame + address + command) via IR
+void SAM_sendCode(uint8_t addr, uint8_t cmd) {
+  uint8_t data[4] = {addr, addr, cmd, ~cmd};  // address twice, command and inverse
+
+  // Prepare carrier wave
+  IR_carrier(NEC_FREQ);                       // set PWM frequency and duty cycle
+
+  // Send telegram
+  do {
+    IR_start();
+    PD_send(&SAM_protocol, data, 32);         // header, 32 bits, end mark
+    SAM_repeatPause();                        // wait for next repeat
+  } while(KEY_read());                        // repeat sending until button is released
+}
+
+// ===================================================================================
+// SAMSUNG36 and SAMSUNG48 Protocol Variants
+// ===================================================================================
+//
+// Both variants use the pulse distance bits of the Samsung protocol (38kHz, mark of
+// one unit, "0" space of one unit, "1" space of three units), sent LSB first by the
+// shared encoder PD_send(). They only differ in their descriptors:
+//
+// SAMSUNG36 (unit 500us): 4.5ms mark, 4.5ms space, device D (8 bits) and sub-device S
+// (8 bits), a 500us mark and a 4.5ms mid-frame gap, then extension E (4 bits),
+// function F (8 bits) and the inverse of F (8 bits), a final 500us mark and 59ms.
+//
+// SAMSUNG48 (unit 560us): 4.5ms mark, 4.5ms space, device D, sub-device S, command
+// byte E, inverse of E, command byte F, inverse of F, a final 560us mark. The frame is
+// repeated every 108ms.
+//
+// The address is passed as D + (S << 8), the command as F + (E << 8). Both telegrams
+// are repeated as long as the key remains down.
+
+#define SAM_unit(us, n)     IR_ticks((us) * (n))
+
+static const PD_protocol_t SAM36_protocol[2] = {
+  {                                                   // D, S, mid-frame gap
+    .hdrMark   = IR_ticks(4500),
+    .hdrSpace  = IR_ticks(4500),
+    .bitMark   = SAM_unit(500, 1),
+    .zeroSpace = SAM_unit(500, 1),
+    .oneSpace  = SAM_unit(500, 3),
+    .stopMark  = SAM_unit(500, 1),
+    .stopSpace = IR_ticks(4500),
+    .flags     = PD_LSB_FIRST
+  },
+  {                                                   // E, F, ~F
+    .bitMark   = SAM_unit(500, 1),
+    .zeroSpace = SAM_unit(500, 1),
+    .oneSpace  = SAM_unit(500, 3),
+    .stopMark  = SAM_unit(500, 1),
+    .stopSpace = SAM_unit(500, 118),
+    .flags     = PD_LSB_FIRST
+  }
+};
+
+static const PD_protocol_t SAM48_protocol = {
+  .hdrMark   = IR_ticks(4500),
+  .hdrSpace  = IR_ticks(4500),
+  .bitMark   = SAM_unit(560, 1),
+  .zeroSpace = SAM_unit(560, 1),
+  .oneSpace  = SAM_unit(560, 3),
+  .stopMark  = SAM_unit(560, 1),
+  .flags     = PD_LSB_FIRST
+};
+#define SAM48_REPEAT        IR_ticks(108000)        // frame repeat interval
+
+// Send SAMSUNG36 telegram (addr: D + S << 8, cmd: F + E << 8, E has 4 bits) via IR
+void SAM36_sendCode(uint16_t addr, uint16_t cmd) {
+  uint8_t  head[2] = {addr, addr >> 8};
+  uint32_t tail    = ((cmd >> 8) & 0x0f)                // E
+                   | ((uint32_t)(cmd & 0xff) << 4)      // F
+                   | ((uint32_t)(~cmd & 0xff) << 12);   // ~F
+  uint8_t  data[3] = {tail, tail >> 8, tail >> 16};
+
+  // Prepare carrier wave
+  IR_carrier(NEC_FREQ);                       // set PWM frequency and duty cycle
+
+  // Send telegram
+  IR_start();
+  do {
+    PD_send(&SAM36_protocol[0], head, 16);    // D, S and mid-frame gap
+    PD_send(&SAM36_protocol[1], data, 20);    // E, F, ~F and final pause
+  } while(KEY_read());                        // repeat sending until button is released
+}
+
+// Send SAMSUNG48 telegram (addr: D + S << 8, cmd: F + E << 8) via IR
+void SAM48_sendCode(uint16_t addr, uint16_t cmd) {
+  uint8_t data[6] = {addr, addr >> 8, cmd >> 8, ~cmd >> 8, cmd, ~cmd};
+
+  // Prepare carrier wave
+  IR_carrier(NEC_FREQ);                       // set PWM frequency and duty cycle
+
+  // Send telegram
+  IR_start();
+  do {
+    uint32_t start = IR_time;
+    PD_send(&SAM48_protocol, data, 48);       // send frame
+    IR_spaceTicks(start + SAM48_REPEAT - IR_time);  // wait for next repeat
+  } while(KEY_read());                        // repeat sending until button is released
+}
+#endif  // USE_SAM > 0
+
+#if USE_RC5 > 0
+// ===================================================================================
+// RC-5 Protocol Implementation
+// ===================================================================================
+//
+// The RC-5 protocol uses bi-phase modulation (Manchester coding).
+//
+//   +-------+                     +-------+    ON
+//           |                     |
+//     889us | 889us         889us | 889us
+//           |                     |
+//           +-------+     +-------+            OFF
+//
+//   |<-- Bit "0" -->|     |<-- Bit "1" -->|
+//
+// IR telegram starts with two start bits. The first bit is always "1",
+// the second bit is "1" in the original protocol and inverted 7th bit
+// of the command in the extended RC-5 protocol. The third bit toggles
+// after each button release. The next five bits represent the device
+// address, MSB first and the last six bits represent the command, MSB
+// first.
+//
+// As long as a key remains down the telegram will be repeated every
+// 114ms without changing the toggle bit.
+
+// Define carrier frequency in Hertz
+#define RC5_FREQ            36000
+
+// Macros to modulate the signals according to RC-5 protocol (spec timings, absolute edges)
+#define RC5_bit0Pulse()     {IR_markTicks(RC5_HALF);  IR_spaceTicks(RC5_HALF);}
+#define RC5_bit1Pulse()     {IR_spaceTicks(RC5_HALF); IR_markTicks(RC5_HALF);}
+#define RC5_repeatPause()   IR_spaceTicks(IR_ticks(114000 - 14 * 2 * 889)) // 114ms period
+#define RC5_HALF            IR_ticks(889)
+
+// Bitmasks
+#define RC5_startBit        0b0010000000000000
+#define RC5_cmdBit7         0b0001000000000000
+#define RC5_toggleBit       0b0000100000000000
+
+// Toggle variable
+uint8_t RC5_toggle = 0;
+
+// Send complete telegram (startbits + togglebit + address + command) via IR
+void RC5_sendCode(uint8_t addr, uint8_t cmd) {
+  // Prepare carrier wave
+  IR_carrier(RC5_FREQ);                       // set PWM frequency and duty cycle
+
+  // Prepare the message
+  uint16_t message = addr << 6;               // shift address to the right position
+  message |= (cmd & 0x3f);                    // add the low 6 bits of the command
+  if(~cmd & 0x40) message |= RC5_cmdBit7;     // add inverse of 7th command bit
+  message |= RC5_startBit;                    // add start bit
+  if(RC5_toggle) message |= RC5_toggleBit;    // add toggle bit
+
+  // Send the message
+  do {
+    uint16_t bitmask = RC5_startBit;          // set the bitmask to first bit to send
+    IR_start();                               // edges of the frame from now on
+    for(uint8_t i=14; i; i--, bitmask>>=1) {  // 14 bits, MSB first
+      (message & bitmask) ? (RC5_bit1Pulse()) : (RC5_bit0Pulse());  // send the bit
+    }
+    RC5_repeatPause();                        // switch off IR LED, wait for next repeat
+  } while(KEY_read());                        // repeat sending until button is released
+  RC5_toggle ^= 1;                            // toggle the toggle bit
+}
+#endif  // USE_RC5 > 0
+
+#if USE_SON > 0
+// ===================================================================================
+// SONY SIRC Protocol Implementation
+// ===================================================================================
+//
+// The SONY SIRC protocol uses pulse length modulation.
+//
+//       +--------------------+     +-----+     +----------+     +-- ON
+//       |                    |     |     |     |          |     |
+//       |       2400us       |600us|600us|600us|  1200us  |600us|   ...
+//       |                    |     |     |     |          |     |
+// ------+                    +-----+     +-----+          +-----+   OFF
+//
+//       |<------ Start Frame ----->|<- Bit=0 ->|<--- Bit=1 ---->| 
+//
+// A "0" bit is a 600us burst followed by a 600us space, a "1" bit is a
+// 1200us burst followed by a 600us space. An IR telegram starts with a
+// 2400us leading burst followed by a 600us space. The command and
+// address bits are then transmitted, LSB first. Depending on the
+// protocol version, these are in detail:
+// - 12-bit version: 7 command bits, 5 address bits
+// - 15-bit version: 7 command bits, 8 address bits
+// - 20-bit version: 7 command bits, 5 address bits, 8 extended bits
+//
+// As long as a key remains down the message will be repeated every 45ms.
+
+// Define carrier frequency in Hertz
+#define SON_FREQ            40000
+
+// Macros to modulate the signals according to SONY protocol (spec timings, absolute edges)
+#define SON_startPulse()    {IR_start(); IR_markLead(IR_ticks(2400)); SON_space();}
+#define SON_bit0Pulse()     {IR_markTicks(IR_ticks( 600)); SON_space();}
+#define SON_bit1Pulse()     {IR_markTicks(IR_ticks(1200)); SON_space();}
+#define SON_repeatPause()   IR_pause(27)
+#define SON_space()         IR_spaceTicks(IR_ticks(600))
+
+// Send "number" of bits of "value" via IR
+void SON_sendByte(uint8_t value, uint8_t number) {
+  do {                                        // send number of bits, LSB first
+    (value & 1) ? (SON_bit1Pulse()) : (SON_bit0Pulse());  // send bit
+    value>>=1;                                // next bit
+  } while(--number);
+}
+
+// Send complete telegram (start frame + command + address) via IR
+void SON_sendCode(uint16_t addr, uint8_t cmd, uint8_t bits) {
+  // Prepare carrier wave
+  IR_carrier(SON_FREQ);                       // set PWM frequency and duty cycle
+
+  // Send telegram
+  do {
+    SON_startPulse();                         // signify start of transmission
+    SON_sendByte(cmd, 7);                     // send 7 command bits
+    switch(bits) {
+      case 12: SON_sendByte(addr, 5); break;  // 12-bit version: send 5 address bits
+      case 15: SON_sendByte(addr, 8); break;  // 15-bit version: send 8 address bits
+      case 20: SON_sendByte(addr, 8); SON_sendByte(addr>>8, 5); break; // 20-bit: 13 bits
+      default: break;
+    }
+    SON_repeatPause();                        // wait until next repeat
+  } while(KEY_read());                        // repeat sending until button is released
+}
+#endif  // USE_SON > 0
+
+#if USE_LPF > 0
+// ===================================================================================
+// LEGO Power Functions Protocol Implementation
+// ===================================================================================
+//
+// The LEGO Power Functions protocol uses pulse distance modulation with a carrier
+// frequency of 38kHz. All timings are multiples of the carrier period.
+//
+//       +-+          +-+   +-+      +-+          +-    ON
+//       | |  1026us  | |   | |      | |  1026us  |           mark:   158us (6 periods)
+//       | |  start   | | 0 | |  1   | |   stop   |           bit0:   263us (10 periods)
+//       | |          | |   | |      | |          |           bit1:   553us (21 periods)
+// ------+ +----------+ +---+ +------+ +----------+     OFF   start: 1026us (39 periods)
+//
+// A message starts with a mark and a 1026us space, followed by 16 bits (four nibbles),
+// most significant bit first, and ends with a mark and a 1026us space (stop bit):
+// - nibble 1: toggle bit, escape bit, 2-bit channel
+// - nibble 2: address bit, 3-bit mode
+// - nibble 3: 4-bit data
+// - nibble 4: checksum (0xF ^ nibble 1 ^ nibble 2 ^ nibble 3)
+// The toggle bit changes with every new key press.
+//
+// Each message is sent five times. The time from the start of a message to the start
+// of the next one depends on the channel (Ch = 1..4), in units of tm = 16ms (maximum
+// message length), so that remotes on different channels don't keep colliding:
+// - before message 1:    (4 - Ch) * tm
+// - before message 2, 3:        5 * tm
+// - before message 4, 5: (6 + 2 * Ch) * tm
+// As long as the key remains down, the message is repeated at the last interval.
+
+// Define carrier frequency in Hertz
+#define LPF_FREQ            38000
+
+// Timings in system ticks, derived from the number of carrier periods
+#define LPF_periods(n)      IR_ticks((n) * 1000000.0 / LPF_FREQ)
+#define LPF_TM              IR_ticks(16000)         // maximum message length
+
+static const PD_protocol_t LPF_protocol = {
+  .hdrMark   = LPF_periods( 6),                       // start bit
+  .hdrSpace  = LPF_periods(39),
+  .bitMark   = LPF_periods( 6),                       // data bits
+  .zeroSpace = LPF_periods(10),
+  .oneSpace  = LPF_periods(21),
+  .stopMark  = LPF_periods( 6),                       // stop bit
+  .stopSpace = LPF_periods(39),
+  .flags     = PD_MSB_FIRST
+};
+
+// Toggle variable
+uint8_t LPF_toggle = 0;
+
+// Send message (ch: channel 0..3, mode: escape bit 4, address bit 3, mode bits 2..0,
+// data: 4 bits) according to the channel's repeat schedule
+void LPF_sendCode(uint8_t ch, uint8_t mode, uint8_t data) {
+  // Prepare the message
+  uint8_t nibble1 = (LPF_toggle << 3) | ((mode >> 2) & 0x04) | (ch & 0x03);
+  uint8_t nibble2 = mode & 0x0f;
+  uint8_t nibble3 = data & 0x0f;
+  uint8_t message[2];
+  message[0] = (nibble1 << 4) | nibble2;
+  message[1] = (nibble3 << 4) | (0x0f ^ nibble1 ^ nibble2 ^ nibble3);
+
+  // Prepare carrier wave
+  IR_carrier(LPF_FREQ);                       // set PWM frequency and duty cycle
+
+  // Send the message
+  ch &= 0x03;
+  IR_start();
+  uint32_t start = IR_time;
+  uint8_t  count = 0;
+  do {
+    if(count == 0)     start += (3 - ch)     * LPF_TM;  // (4 - Ch) * tm
+    else if(count < 3) start += 5            * LPF_TM;  // 5 * tm
+    else               start += (8 + 2 * ch) * LPF_TM;  // (6 + 2 * Ch) * tm
+    IR_spaceTicks(start - IR_time);           // wait for start of message
+    PD_send(&LPF_protocol, message, 16);      // send message
+    if(count < 5) count++;
+  } while(count < 5 || KEY_read());           // repeat until sent 5 times and key released
+  LPF_toggle ^= 1;                            // toggle the toggle bit
+}
+#endif  // USE_LPF > 0
+
+#if USE_RMM > 0
+// ===================================================================================
+// Nokia RC-MM Protocol Implementation
+// ===================================================================================
+//
+// The RC-MM protocol uses pulse distance modulation with a carrier frequency of 36kHz
+// and encodes two bits per symbol. All timings are multiples of the carrier period
+// (27.8us).
+//
+//       +-----+     +--+   +--+     +--+       +--+         +--+   ON
+//       |     |     |  |   |  |     |  |       |  |         |  |
+//       |417us|278us|  |00 |  | 01  |  |  10   |  |   11    |  |   ...
+//       |     |     |  |   |  |     |  |       |  |         |  |
+// ------+     +-----+  +---+  +-----+  +-------+  +---------+  +-- OFF
+//
+// A frame starts with a 417us mark and a 278us space. Each symbol is a 167us mark
+// followed by a space of 278us (00), 444us (01), 611us (10) or 778us (11). The bits
+// are sent MSB first, a final 167us mark ends the frame. There are 12-bit, 24-bit and
+// 32-bit frames. As long as the key remains down, the frame is repeated every 27.8ms
+// (1000 carrier periods).
+//
+// The marks and spaces are too short to calculate the next symbol in between, so the
+// frame is expanded into a list of edges first and sent by IR_sendEdges().
+
+// Define carrier frequency in Hertz
+#define RMM_FREQ            36000
+
+// Timings in system ticks, derived from the number of carrier periods
+#define RMM_periods(n)      IR_ticks((n) * 1000000.0 / RMM_FREQ)
+#define RMM_REPEAT          RMM_periods(1000)       // frame repeat interval
+
+static const uint32_t RMM_space[4] = {
+  RMM_periods(10), RMM_periods(16), RMM_periods(22), RMM_periods(28)
+};
+
+// Send frame with the number of bits (12, 24 or 32) of data via IR, other numbers of
+// bits send nothing
+void RMM_sendCode(uint32_t data, uint8_t bits) {
+  uint32_t edges[2 + 32 + 1];
+  uint8_t  count = 0;
+
+  // Check the frame length (edges[] holds 32 bits, shifts by 32 or more are undefined)
+  if(bits != 12 && bits != 24 && bits != 32) return;
+
+  // Expand the frame
+  edges[count++] = RMM_periods(15);           // header mark
+  edges[count++] = RMM_periods(10);           // header space
+  while(bits >= 2) {                          // symbols, MSB first
+    bits -= 2;
+    edges[count++] = RMM_periods(6);
+    edges[count++] = RMM_space[(data >> bits) & 3];
+  }
+  edges[count++] = RMM_periods(6);            // stop mark
+
+  // Prepare carrier wave
+  IR_carrier(RMM_FREQ);                       // set PWM frequency and duty cycle
+
+  // Send the frame
+  IR_start();
+  do {
+    uint32_t start = IR_time;
+    IR_sendEdges(edges, count);               // send frame
+    IR_spaceTicks(start + RMM_REPEAT - IR_time);  // wait for next repeat
+  } while(KEY_read());                        // repeat sending until button is released
+}
+#endif  // USE_RMM > 0
+
+#if USE_XMP > 0
+// ===================================================================================
+// Motorola XMP Protocol Implementation
+// ===================================================================================
+//
+// The XMP protocol uses a carrier frequency of 38kHz and encodes a nibble n per
+// symbol: a 210us mark followed by a space of 760us + n * 136us.
+//
+//       +--+        +--+              +--+                      +--+   ON
+//       |  |  760us |  |   1032us     |  |        2800us        |  |
+//       |  |   n=0  |  |    n=2       |  |         n=15         |  |   ...
+// ------+  +--------+  +--------------+  +----------------------+  +-- OFF
+//
+// A frame consists of two packets of 8 nibbles, MSB first, each ended by a 210us mark.
+// The packets are separated by 13.8ms, the frame is followed by 80.4ms:
+// - packet 1: S high, C1, S low, 0xF, OEM high, OEM low, D high, D low
+// - packet 2: S high, C2, T, S low, F (4 nibbles, MSB first)
+// S is the sub-device, OEM the manufacturer code, D the device and F the 16-bit
+// function. C1 and C2 are checksums, the nibbles of each packet add up to 0 (mod 16).
+// T is 0 in the first frame and 8 in the repeats sent while the key remains down.
+
+// Define carrier frequency in Hertz
+#define XMP_FREQ            38000
+
+// Timings in system ticks
+#define XMP_MARK            IR_ticks(210)
+#define XMP_nibble(n)       IR_ticks(760 + 136 * (n))
+#define XMP_GAP             IR_ticks(13800)         // between packets
+#define XMP_REPEAT          IR_ticks(80400)         // after frame
+
+static const uint32_t XMP_space[16] = {
+  XMP_nibble( 0), XMP_nibble( 1), XMP_nibble( 2), XMP_nibble( 3),
+  XMP_nibble( 4), XMP_nibble( 5), XMP_nibble( 6), XMP_nibble( 7),
+  XMP_nibble( 8), XMP_nibble( 9), XMP_nibble(10), XMP_nibble(11),
+  XMP_nibble(12), XMP_nibble(13), XMP_nibble(14), XMP_nibble(15)
+};
+
+// Expand a packet of 8 nibbles (packed MSB first in value) with checksum in nibble 2
+// into edges, returns pointer behind the packet
+static uint32_t* XMP_packet(uint32_t* edges, uint32_t value, uint32_t gap) {
+  uint8_t sum = 0;
+  for(uint8_t i=0; i<32; i+=4) sum -= (value >> i) & 0x0f;
+  value |= (uint32_t)(sum & 0x0f) << 24;      // add checksum
+  for(uint8_t i=32; i; ) {
+    i -= 4;
+    *edges++ = XMP_MARK;
+    *edges++ = XMP_space[(value >> i) & 0x0f];
+  }
+  *edges++ = XMP_MARK;                        // end of packet
+  *edges++ = gap;
+  return edges;
+}
+
+// Send complete telegram (OEM code, device, sub-device, function) via IR. The frame is
+// expanded once per key press. The repeats only differ in packet 2 (T and C2), which
+// is expanded again a single time during the pause after the first frame, so that the
+// repeats start on time.
+void XMP_sendCode(uint8_t oem, uint8_t dev, uint8_t sub, uint16_t func) {
+  uint32_t edges[2 * 18];
+  uint32_t high = (uint32_t)(sub & 0xf0) << 24;  // S high is the first nibble of both
+  uint32_t packet2 = high | ((uint32_t)(sub & 0x0f) << 16) | func;
+  uint32_t* edges2;
+
+  // Expand the frame
+  edges2 = XMP_packet(edges, high | ((uint32_t)(sub & 0x0f) << 20) | 0xf0000
+                                  | ((uint16_t)oem << 8) | dev, XMP_GAP);
+  XMP_packet(edges2, packet2, 0);
+
+  // Prepare carrier wave
+  IR_carrier(XMP_FREQ);                       // set PWM frequency and duty cycle
+
+  // Send the frames
+  IR_start();
+  do {
+    IR_sendEdges(edges, 2 * 18 - 1);          // send frame up to the last mark
+    if(!(packet2 & 0x00f00000)) {             // first frame: set T for the repeats
+      packet2 |= (uint32_t)8 << 20;
+      XMP_packet(edges2, packet2, 0);
+    }
+    IR_spaceTicks(XMP_REPEAT);                // pause after frame
+  } while(KEY_read());                        // repeat sending until button is released
+}
+#endif  // USE_XMP > 0
@@ -0,0 +1,105 @@
+// ===================================================================================
+// IR Protocol Encoders                                                       * v1.2 *
+// ===================================================================================
+//
+// Functions available:
+// --------------------
+// NEC_sendCode(addr, cmd)        send NEC telegram, 8-bit or 16-bit (extended) address
+// SAM_sendCode(addr, cmd)        send Samsung telegram
+// SAM36_sendCode(addr, cmd)      send Samsung36 telegram (addr 16 bits, cmd 12 bits)
+// SAM48_sendCode(addr, cmd)      send Samsung48 telegram (addr 16 bits, cmd 16 bits)
+// RC5_sendCode(addr, cmd)        send RC-5 telegram, 7-bit command (extended RC-5)
+// SON_sendCode(addr, cmd, bits)  send Sony SIRC telegram, bits = 12, 15 or 20
+// LPF_sendCode(ch, mode, data)   send LEGO Power Functions message, channel 0..3
+// RMM_sendCode(data, bits)       send Nokia RC-MM frame, bits = 12, 24 or 32 (else none)
+// XMP_sendCode(oem, dev, sub, func)  send Motorola XMP telegram, 16-bit function
+//
+// PD_send(proto, data, bits)     send bits of data by pulse distance descriptor proto
+//
+// All *_sendCode functions repeat the telegram according to the protocol until
+// KEY_read() returns 0.
+//
+// Notes:
+// ------
+// - Protocols can be excluded in config.h by setting USE_NEC, USE_SAM, USE_RC5,
+//   USE_SON, USE_LPF, USE_RMM or USE_XMP to "0". All protocols are included if not
+//   otherwise defined.
+// - A pulse distance protocol is described by a PD_protocol_t in flash. Its timings
+//   are given in system ticks, calculated by IR_ticks() from the nominal values at
+//   compile time, the shared encoder PD_send() sends them with absolute timing.
+// - The application must provide KEY_read() (returns 0 if no key is pressed).
+//   It is called once after each frame, so it should be quick (see main.c: the key
+//   release is latched by an EXTI flag, which is one register read per frame).
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "ir.h"
+
+// ===================================================================================
+// Protocol Selection
+// ===================================================================================
+#ifndef USE_NEC
+  #define USE_NEC           1
+#endif
+#ifndef USE_SAM
+  #define USE_SAM           1
+#endif
+#ifndef USE_RC5
+  #define USE_RC5           1
+#endif
+#ifndef USE_SON
+  #define USE_SON           1
+#endif
+#ifndef USE_LPF
+  #define USE_LPF           1
+#endif
+#ifndef USE_RMM
+  #define USE_RMM           1
+#endif
+#ifndef USE_XMP
+  #define USE_XMP           1
+#endif
+#define USE_IR              (USE_NEC + USE_SAM + USE_RC5 + USE_SON + USE_LPF \
+                           + USE_RMM + USE_XMP)
+
+// ===================================================================================
+// Pulse Distance Protocol Descriptor
+// ===================================================================================
+typedef struct {
+  uint32_t hdrMark;                                     // header mark (0: none)
+  uint32_t hdrSpace;                                    // header space
+  uint32_t bitMark;                                     // mark of each bit
+  uint32_t zeroSpace;                                   // space of a "0" bit
+  uint32_t oneSpace;                                    // space of a "1" bit
+  uint32_t stopMark;                                    // stop mark (0: none)
+  uint32_t stopSpace;                                   // space after stop mark
+  uint8_t  flags;                                       // PD_MSB_FIRST
+} PD_protocol_t;                                        // all timings in system ticks
+
+#define PD_LSB_FIRST        0x00                        // bits of each byte LSB first
+#define PD_MSB_FIRST        0x01                        // bits of each byte MSB first
+
+// ===================================================================================
+// Protocol Functions
+// ===================================================================================
+uint8_t KEY_read(void);                                 // provided by the application
+
+void NEC_sendCode(uint16_t addr, uint8_t cmd);          // send NEC telegram
+void SAM_sendCode(uint8_t addr, uint8_t cmd);           // send Samsung telegram
+void SAM36_sendCode(uint16_t addr, uint16_t cmd);       // send Samsung36 telegram
+void SAM48_sendCode(uint16_t addr, uint16_t cmd);       // send Samsung48 telegram
+void RC5_sendCode(uint8_t addr, uint8_t cmd);           // send RC-5 telegram
+void SON_sendCode(uint16_t addr, uint8_t cmd, uint8_t bits);  // send SIRC telegram
+void LPF_sendCode(uint8_t ch, uint8_t mode, uint8_t data);    // send LEGO PF message
+void RMM_sendCode(uint32_t data, uint8_t bits);               // send RC-MM frame
+void XMP_sendCode(uint8_t oem, uint8_t dev, uint8_t sub, uint16_t func);  // send XMP
+
+void PD_send(const PD_protocol_t* proto, const uint8_t* data, uint8_t bits);
+
+#ifdef __cplusplus
+};
+#endif
@@ -103,6 +103,11 @@ void DLY_ticks(uint32_t n) {
   while(((int32_t)(STK->CNT - end)) < 0);
 }
 
+// Wait until SysTick reaches t, a deadline in the past returns at once
+void DLY_until(uint32_t t) {
+  while(((int32_t)(STK->CNT - t)) < 0);
+}
+
 // ===================================================================================
 // Bootloader (BOOT) Functions
 // ===================================================================================
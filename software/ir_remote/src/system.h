@@ -44,6 +44,9 @@
 // DLY_ticks(n)             delay n clock cycles
 // DLY_us(n)                delay n microseconds
 // DLY_ms(n)                delay n milliseconds
+// DLY_now()                current time in system ticks
+// DLY_until(t)             wait until time t in system ticks (absolute deadline)
+// DLY_TICKS(us)            microseconds into system ticks, rounded
 //
 // Reset (RST) and Bootloader (BOOT) functions available:
 // ------------------------------------------------------
@@ -238,9 +241,27 @@ void MCO_init(void);                                    // init clock output to
 #define STK_init()        STK->CTLR = STK_CTLR_STE | STK_CTLR_STCLK // init SYSTICK @ F_CPU
 #define DLY_US_TIME       (F_CPU / 1000000)                   // system ticks per us
 #define DLY_MS_TIME       (F_CPU / 1000)                      // system ticks per ms
-#define DLY_us(n)         DLY_ticks((n) * DLY_MS_TIME / 1000) // delay n microseconds
-#define DLY_ms(n)         DLY_ticks((n) * DLY_MS_TIME)        // delay n milliseconds
+#define DLY_TICKS(us)     (((us) * DLY_MS_TIME + 500) / 1000) // us into ticks, rounded
+#define DLY_us(n)         DLY_ticks(DLY_COMP(DLY_TICKS(n)))   // delay n microseconds
+#define DLY_ms(n)         DLY_ticks(DLY_COMP((n) * DLY_MS_TIME)) // delay n milliseconds
+#define DLY_now()         (STK->CNT)                          // current time in ticks
 void DLY_ticks(uint32_t n);                                   // delay n system ticks
+void DLY_until(uint32_t t);                                   // wait until tick t
+
+// Instruction timing of the QingKe V2A core without flash wait states (F_CPU <= 24MHz),
+// used by the delay compensation, the IR_GEN_BITBANG loop and sim/format_bench
+#define CYC_ALU           1                   // ALU instruction, store, branch not taken
+#define CYC_LOAD          2                   // lb, lbu, lh, lhu, lw
+#define CYC_JUMP          2                   // taken branch, jal, jalr, ret
+
+// Cycles of a DLY_ticks() call beyond n: load of n and call, SysTick read, end time,
+// half a poll loop (lw, sub, taken bltz) and loop exit with return. Subtracted by
+// DLY_us() and DLY_ms(), so the delay between the instructions before and after the
+// call is n.
+#define DLY_CYC_POLL      (CYC_LOAD + CYC_ALU + CYC_JUMP)
+#define DLY_OVERHEAD      ((CYC_ALU + CYC_JUMP) + (CYC_ALU + CYC_LOAD) + CYC_ALU \
+                          + DLY_CYC_POLL / 2 + (CYC_ALU + CYC_JUMP))
+#define DLY_COMP(t)       ((t) > DLY_OVERHEAD ? (t) - DLY_OVERHEAD : 0)
 
 // ===================================================================================
 // Reset (RST) Functions
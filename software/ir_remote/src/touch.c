@@ -0,0 +1,166 @@
+// ===================================================================================
+// Capacitive Touch Keys on ADC Pins for CH32V003                             * v1.0 *
+// ===================================================================================
+
+#include "touch.h"
+#include "debug.h"
+
+#if TOUCH_ENABLE > 0 || defined(TOUCH_HOST)
+
+static uint32_t TOUCH_base[TOUCH_KEYS];       // baselines * 2^TOUCH_DRIFT
+static uint16_t TOUCH_count[TOUCH_KEYS];      // scans above TOUCH_ON / of the touch
+static uint8_t  TOUCH_state;                  // bit n: pad n touched
+static uint8_t  TOUCH_wait;                   // bit n: touch of pad n to be confirmed
+static uint8_t  TOUCH_near;                   // scans since a finger was near
+static uint8_t  TOUCH_fast;                   // 1: AWU at TOUCH_FAST
+
+#ifndef TOUCH_HOST
+// ===================================================================================
+// Touch Pads, ADC and AWU
+// ===================================================================================
+#include "system.h"
+#include "gpio.h"
+
+#define TOUCH_period(ms)  AWU_set(ms)
+
+// Measure one pad: discharge, release and sample while it charges through TOUCH_R
+static inline __attribute__((always_inline)) uint16_t TOUCH_pin(uint8_t pin) {
+  uint16_t sum = 0;
+  ADC_input(pin);
+  for(uint8_t i=0; i<TOUCH_SAMPLES; i++) {
+    PIN_output(pin);                          // discharge pad (output is low)
+    PIN_input_AN(pin);                        // release pad ...
+    ADC1->CTLR2 |= ADC_SWSTART;               // ... and sample it while it charges
+    while(!(ADC1->STATR & ADC_EOC));
+    sum += ADC1->RDATAR;
+  }
+  return sum;
+}
+
+// Measure all pads and update their state
+void TOUCH_scan(void) {
+  uint16_t raw[TOUCH_KEYS];
+  ADC_enable();
+  DLY_us(TOUCH_SETTLE);
+  raw[0] = TOUCH_pin(PIN_TOUCH1);
+  raw[1] = TOUCH_pin(PIN_TOUCH2);
+  raw[2] = TOUCH_pin(PIN_TOUCH3);
+  raw[3] = TOUCH_pin(PIN_TOUCH4);
+  ADC_disable();
+  for(uint8_t key=0; key<TOUCH_KEYS; key++) TOUCH_update(key, raw[key]);
+}
+
+// Init pads (analog input, output latch low) and ADC, calibrate baselines, start AWU
+void TOUCH_init(void) {
+  PIN_low(PIN_TOUCH1); PIN_input_AN(PIN_TOUCH1);
+  PIN_low(PIN_TOUCH2); PIN_input_AN(PIN_TOUCH2);
+  PIN_low(PIN_TOUCH3); PIN_input_AN(PIN_TOUCH3);
+  PIN_low(PIN_TOUCH4); PIN_input_AN(PIN_TOUCH4);
+  ADC_init();
+  ADC_fast();
+  TOUCH_base[0] = (uint32_t)TOUCH_pin(PIN_TOUCH1) << TOUCH_DRIFT;
+  TOUCH_base[1] = (uint32_t)TOUCH_pin(PIN_TOUCH2) << TOUCH_DRIFT;
+  TOUCH_base[2] = (uint32_t)TOUCH_pin(PIN_TOUCH3) << TOUCH_DRIFT;
+  TOUCH_base[3] = (uint32_t)TOUCH_pin(PIN_TOUCH4) << TOUCH_DRIFT;
+  ADC_disable();
+  TOUCH_near = TOUCH_IDLE;                    // start with slow scan rate
+  AWU_start(TOUCH_SLOW);                      // wake up from standby every TOUCH_SLOW ms
+}
+
+#else
+// ===================================================================================
+// Host Backend
+// ===================================================================================
+#define TOUCH_period(ms)  TOUCH_HOST_period(ms)
+
+static uint16_t TOUCH_pin(uint8_t key) {
+  uint16_t sum = 0;
+  for(uint8_t i=0; i<TOUCH_SAMPLES; i++) sum += TOUCH_HOST_measure(key);
+  return sum;
+}
+
+void TOUCH_scan(void) {
+  for(uint8_t key=0; key<TOUCH_KEYS; key++) TOUCH_update(key, TOUCH_pin(key));
+}
+
+void TOUCH_init(void) {
+  for(uint8_t key=0; key<TOUCH_KEYS; key++) {
+    TOUCH_base[key]  = (uint32_t)TOUCH_pin(key) << TOUCH_DRIFT;
+    TOUCH_count[key] = 0;
+  }
+  TOUCH_state = 0;
+  TOUCH_wait  = 0;
+  TOUCH_near  = TOUCH_IDLE;
+  TOUCH_fast  = 0;
+  TOUCH_period(TOUCH_SLOW);
+}
+
+#endif  // TOUCH_HOST
+
+// ===================================================================================
+// Baseline Tracking and Touch Detection
+// ===================================================================================
+
+// Update state of pad key with measurement raw, returns 1 if touched
+uint8_t TOUCH_update(uint8_t key, uint16_t raw) {
+  uint8_t mask  = (uint8_t)1 << key;
+  int16_t delta = (int16_t)(TOUCH_base[key] >> TOUCH_DRIFT) - raw;
+  if(delta >= TOUCH_OFF) TOUCH_near = 0;      // finger near
+  if(TOUCH_state & mask) {
+    if(delta < TOUCH_OFF) {                   // released
+      TOUCH_state &= ~mask;
+      TOUCH_count[key] = 0;
+      DBG_print("TOUCH off "); DBG_printD(key + 1); DBG_write('\n');
+    }
+    else if(++TOUCH_count[key] >= TOUCH_TIMEOUT) {  // stuck: new baseline
+      TOUCH_base[key]  = (uint32_t)raw << TOUCH_DRIFT;
+      TOUCH_state     &= ~mask;
+      TOUCH_count[key] = 0;
+      DBG_print("TOUCH recal "); DBG_printD(key + 1); DBG_write('\n');
+    }
+  }
+  else if(delta >= TOUCH_ON) {
+    TOUCH_wait |= mask;
+    if(++TOUCH_count[key] >= TOUCH_CONFIRM) { // touched
+      TOUCH_state     |= mask;
+      TOUCH_wait      &= ~mask;
+      TOUCH_count[key] = 0;
+      DBG_print("TOUCH on "); DBG_printD(key + 1); DBG_write('\n');
+    }
+  }
+  else {
+    TOUCH_wait      &= ~mask;
+    TOUCH_count[key] = 0;
+    if(delta <= -TOUCH_OFF) {                 // object removed: take reading at once
+      TOUCH_base[key]  = (uint32_t)raw << TOUCH_DRIFT;
+    }
+    else if(delta < TOUCH_OFF) {              // no finger: follow drift
+      TOUCH_base[key] += raw;
+      TOUCH_base[key] -= TOUCH_base[key] >> TOUCH_DRIFT;
+    }
+  }
+  return (TOUCH_state & mask) != 0;
+}
+
+// Scan pads and set scan rate, returns number of touched key (lowest) or 0
+uint8_t TOUCH_read(void) {
+  TOUCH_scan();
+  while(TOUCH_wait) TOUCH_scan();             // confirm a touch at once
+  if(TOUCH_near < TOUCH_IDLE) {
+    TOUCH_near++;
+    if(!TOUCH_fast) {                         // finger near: scan faster
+      TOUCH_period(TOUCH_FAST);
+      TOUCH_fast = 1;
+    }
+  }
+  else if(TOUCH_fast) {                       // no finger for TOUCH_IDLE scans
+    TOUCH_period(TOUCH_SLOW);
+    TOUCH_fast = 0;
+  }
+  for(uint8_t key=0; key<TOUCH_KEYS; key++) {
+    if(TOUCH_state & ((uint8_t)1 << key)) return key + 1;
+  }
+  return 0;
+}
+
+#endif  // TOUCH_ENABLE || TOUCH_HOST
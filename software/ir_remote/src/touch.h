@@ -0,0 +1,122 @@
+// ===================================================================================
+// Capacitive Touch Keys on ADC Pins for CH32V003                             * v1.0 *
+// ===================================================================================
+//
+// Reads up to 4 touch pads instead of mechanical keys, so that the remote can be
+// sealed. Each pad is a copper area on the PCB behind the (non-conductive) housing,
+// connected to an ADC pin, with an external resistor TOUCH_R pulling it up to VDD:
+//
+//   VDD --[TOUCH_R 470k]--+---- PIN_TOUCHn
+//                         |
+//                        PAD  (C_pad about 10pF, a finger adds a few pF)
+//
+// A measurement discharges the pad (pin output low) and releases it (analog input)
+// right before the ADC starts a conversion in fast mode. The pad charges through
+// TOUCH_R while the ADC samples, the reading at the end of the sample time (about
+// 5us after the release at 1.5MHz) is the charge level 1 - exp(-t / (TOUCH_R * C)).
+// A finger increases C, so the pad charges more slowly and the reading drops. The
+// timing is given by the instructions between release and ADC start, so it doesn't
+// jitter, and the reading is ratiometric to VDD like all ADC readings.
+//
+// Each scan adds TOUCH_SAMPLES readings per pad. The baseline of a pad (its reading
+// without finger) follows slow drift (temperature, humidity, battery) by an IIR filter
+// while the pad is not touched. A touch is detected if the reading is TOUCH_ON below
+// the baseline in TOUCH_CONFIRM consecutive scans, and released if it's less than
+// TOUCH_OFF below (hysteresis). Between TOUCH_OFF and TOUCH_ON (finger approaching)
+// the baseline is frozen. A touch that lasts TOUCH_TIMEOUT scans (e.g. an object
+// lying on the remote) is taken as the new baseline, a reading TOUCH_OFF above the
+// baseline (the object was removed) at once.
+//
+// Touch pads can't wake the MCU by a pin event, so the automatic wake-up timer (AWU)
+// wakes it from standby every TOUCH_SLOW ms (8 scans per second). A pad that is
+// TOUCH_ON below its baseline is confirmed by rescanning at once, so the latency of a
+// touch is at most TOUCH_SLOW ms plus a few scans, touches shorter than TOUCH_SLOW
+// may be missed. As soon as a pad is more than TOUCH_OFF below its baseline, the
+// period is switched to TOUCH_FAST ms (release and next touch), and back to
+// TOUCH_SLOW after TOUCH_IDLE scans without finger.
+//
+// A scan of 4 pads takes about 0.53ms, with 0.2ms wake-up from standby this is about
+// 0.88uC (2.6uJ at 3V) per scan cycle at 1.2mA. At 8 scans per second this adds about
+// 7uA to the standby current (9uA), at TOUCH_FAST about 44uA while a finger is near.
+// The simulator sim/touch_sim.c runs this code on a model of the pads with drift and
+// noise and reports the energy per scan cycle, the average current, the latency and
+// false or missed touches.
+//
+// Functions available:
+// --------------------
+// TOUCH_init()             init pads and ADC, calibrate baselines, start AWU
+// TOUCH_read()             scan pads, returns number of touched key (0: none)
+// TOUCH_scan()             measure all pads and update their state
+// TOUCH_update(key, raw)   update state of pad key (0..) with measurement raw
+//
+// Notes:
+// ------
+// - The touch keys are disabled unless TOUCH_ENABLE is set to "1" in config.h, the keys
+//   KEY1..KEY4 are then read from PIN_TOUCH1..PIN_TOUCH4 instead of PIN_KEY1..PIN_KEY5.
+// - PIN_TOUCHn must be ADC inputs: PA1, PA2, PC4, PD2, PD3, PD4, PD5 or PD6.
+// - Don't touch the pads at power-up, the baselines are calibrated there.
+// - The AWU is used for scanning, so touch keys can't be combined with wake-on-IR
+//   (WAKE_ENABLE). The ADC is powered down between scans.
+// - If more than one pad is touched, the lowest key wins.
+// - If TOUCH_HOST is defined (host builds), the pads and the AWU are replaced by the
+//   TOUCH_HOST_*() functions, which have to be provided by the host program (see
+//   sim/touch_sim.c).
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <config.h>
+#include <stdint.h>
+
+// ===================================================================================
+// Touch Parameters
+// ===================================================================================
+#ifndef TOUCH_ENABLE
+  #define TOUCH_ENABLE    0                   // 1: keys on capacitive touch pads
+#endif
+#define TOUCH_KEYS        4                   // number of pads
+#define TOUCH_R           470000              // pullup resistor in ohms
+#define TOUCH_SAMPLES     2                   // ADC readings per pad and scan
+#define TOUCH_ON          40                  // touched: this far below baseline
+#define TOUCH_OFF         20                  // released: less than this below baseline
+#define TOUCH_CONFIRM     2                   // scans above TOUCH_ON for a touch
+#define TOUCH_TIMEOUT     1000                // scans of a touch until recalibration
+#define TOUCH_DRIFT       4                   // baseline follows by 1/2^TOUCH_DRIFT
+#ifndef TOUCH_SLOW
+  #define TOUCH_SLOW      125                 // AWU period without finger in ms
+#endif
+#ifndef TOUCH_FAST
+  #define TOUCH_FAST      20                  // AWU period with finger near in ms
+#endif
+#define TOUCH_IDLE        25                  // scans without finger until slow again
+#define TOUCH_SETTLE      10                  // ADC power-up time in us
+
+// ===================================================================================
+// Touch Functions
+// ===================================================================================
+void TOUCH_init(void);                        // init pads, ADC and AWU
+uint8_t TOUCH_read(void);                     // scan pads, returns key (0: none)
+void TOUCH_scan(void);                        // measure all pads and update state
+uint8_t TOUCH_update(uint8_t key, uint16_t raw);  // update pad state, 1: touched
+
+#if TOUCH_ENABLE > 0 && WAKE_ENABLE > 0
+  #error Touch keys and wake-on-IR both need the AWU
+#endif
+#if TOUCH_ENABLE > 0 && LADDER_ENABLE > 0
+  #error Select either touch keys or the resistor ladder
+#endif
+
+#ifdef TOUCH_HOST
+// ===================================================================================
+// Pad and AWU Backend for Host Builds
+// ===================================================================================
+uint16_t TOUCH_HOST_measure(uint8_t key);     // one ADC reading of pad key (0..)
+void TOUCH_HOST_period(uint16_t ms);          // set AWU period
+#endif
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,122 @@
+// ===================================================================================
+// Wake-on-IR with a Duty-Cycled Receiver for CH32V003                        * v1.0 *
+// ===================================================================================
+
+#include "wake.h"
+#include "debug.h"
+
+#if WAKE_ENABLE > 0 || defined(WAKE_HOST)
+
+static uint32_t WAKE_since;                   // time of switching on the receiver
+static uint8_t  WAKE_power;                   // 1: receiver is on
+
+#ifndef WAKE_HOST
+// ===================================================================================
+// Receiver Pins and SysTick
+// ===================================================================================
+#include "system.h"
+#include "gpio.h"
+
+#define WAKE_FREE(PIN)    (PIN != PIN_RXPWR && PIN != PIN_RXOUT)
+_Static_assert(WAKE_FREE(PIN_KEY1) && WAKE_FREE(PIN_KEY2) && WAKE_FREE(PIN_KEY3) &&
+               WAKE_FREE(PIN_KEY4) && WAKE_FREE(PIN_KEY5) && WAKE_FREE(PIN_LED),
+               "PIN_RXPWR or PIN_RXOUT is used by keys or IR LED");
+
+#define WAKE_now()        STK->CNT            // time in ticks
+#define WAKE_TICKS(us)    DLY_TICKS((uint32_t)(us))   // rounded, also below 1MHz
+#define WAKE_until(t)     DLY_until(t)
+
+// Init receiver pins (receiver off) and AWU with event trigger
+void WAKE_init(void) {
+  PORT_enable(PIN_RXPWR);           // enable I/O port of receiver pins
+  PORT_enable(PIN_RXOUT);
+  WAKE_off();
+  PIN_output(PIN_RXPWR);
+  AWU_start(WAKE_PERIOD);           // wake up from standby every WAKE_PERIOD ms
+}
+
+// Switch on receiver, its output has an internal pullup
+void WAKE_on(void) {
+  if(WAKE_power) return;
+  PIN_high(PIN_RXPWR);
+  PIN_input(PIN_RXOUT);
+  WAKE_since = WAKE_now();
+  WAKE_power = 1;
+}
+
+// Switch off receiver, no current through its output
+void WAKE_off(void) {
+  PIN_input_AN(PIN_RXOUT);
+  PIN_low(PIN_RXPWR);
+  WAKE_power = 0;
+}
+
+// 1: receiver detects carrier (output low)
+uint8_t WAKE_carrier(void) {
+  return !PIN_read(PIN_RXOUT);
+}
+
+#else
+// ===================================================================================
+// Host Backend
+// ===================================================================================
+#define WAKE_now()        WAKE_HOST_now()     // time in us
+#define WAKE_TICKS(us)    ((uint32_t)(us))
+#define WAKE_until(t)     {int32_t d = (t) - WAKE_now(); if(d > 0) WAKE_HOST_delay(d);}
+#undef  WAKE_SETTLE                           // tuned by the simulator
+#define WAKE_SETTLE       WAKE_HOST_settle
+#undef  WAKE_WINDOW
+#define WAKE_WINDOW       WAKE_HOST_window
+
+void WAKE_init(void) {
+  WAKE_off();
+}
+
+void WAKE_on(void) {
+  if(WAKE_power) return;
+  WAKE_HOST_power(1);
+  WAKE_since = WAKE_now();
+  WAKE_power = 1;
+}
+
+void WAKE_off(void) {
+  WAKE_HOST_power(0);
+  WAKE_power = 0;
+}
+
+uint8_t WAKE_carrier(void) {
+  return !WAKE_HOST_read();
+}
+
+#endif  // WAKE_HOST
+
+// ===================================================================================
+// Wake-on-IR
+// ===================================================================================
+
+// Power receiver for one window, returns 1 and leaves receiver on if carrier detected.
+// If the receiver was switched on before, the settle time counts from there.
+uint8_t WAKE_check(void) {
+  uint32_t start;
+  WAKE_on();
+  WAKE_until(WAKE_since + WAKE_TICKS(WAKE_SETTLE)); // wait until output is valid
+  start = WAKE_now();
+  do {
+    if(WAKE_carrier()) {
+      DBG_println("WAKE carrier");
+      return 1;
+    }
+  } while((uint32_t)(WAKE_now() - start) < WAKE_TICKS(WAKE_WINDOW));
+  WAKE_off();
+  return 0;
+}
+
+// Stay awake with receiver on until there was no carrier for ms
+void WAKE_idle(uint16_t ms) {
+  uint32_t last = WAKE_now();
+  while((uint32_t)(WAKE_now() - last) < WAKE_TICKS((uint32_t)ms * 1000)) {
+    if(WAKE_carrier()) last = WAKE_now();
+  }
+}
+
+#endif  // WAKE_ENABLE || WAKE_HOST
@@ -0,0 +1,107 @@
+// ===================================================================================
+// Wake-on-IR with a Duty-Cycled Receiver for CH32V003                        * v1.0 *
+// ===================================================================================
+//
+// Detects IR activity in standby without powering the IR receiver all the time. The
+// receiver is supplied by a GPIO (PIN_RXPWR to its VS pin), the automatic wake-up
+// timer (AWU) wakes the MCU every WAKE_PERIOD ms. WAKE_check() then powers the
+// receiver, waits WAKE_SETTLE us until its output is valid and polls the output for
+// WAKE_WINDOW us. If the output goes low (carrier detected), the receiver stays on
+// and the MCU stays awake for capturing (e.g. for a repeater or learning remote),
+// otherwise the receiver is switched off and the MCU goes back to standby.
+//
+// Average current in standby (no IR activity) is about:
+// I = 9uA + (I_MCU * (t_wakeup + WAKE_SETTLE + WAKE_WINDOW) + I_RX * (WAKE_SETTLE +
+//     WAKE_WINDOW)) / WAKE_PERIOD
+// With I_MCU = 1.2mA at 1.5MHz, I_RX = 0.4mA, 200us wake-up time and the default
+// parameters this is 9uA + 41uA = 50uA, i.e. 6 times the standby current. Halving the
+// period doubles the second term. The main loop debounces the keys (1ms) after each
+// wake-up before it takes the wake for an AWU event, with the receiver already on, so
+// the settle time is part of the debounce time: t_wakeup + 1ms + WAKE_WINDOW for the
+// MCU and 1ms + WAKE_WINDOW for the receiver, 9uA + 54uA = 63uA. The defaults detect
+// about 73% of the key presses in sim/wake_sim.c (150ms: 46% at 32uA).
+// A transmission is detected if a mark of at least the receiver's minimum burst
+// length falls into a window. Long marks (e.g. the 9ms leader of NEC) are caught by
+// most windows, short ones (RC-5, RC-MM) need more presses/repeats. The simulator
+// sim/wake_sim.c runs this code with the real transmit timings of all protocols and
+// reports the detection probability, the latency and the average current for a given
+// period, window and settle time.
+//
+// Functions available:
+// --------------------
+// WAKE_init()              init receiver pins (receiver off) and AWU
+// WAKE_check()             look for IR activity in one window, 1: found (receiver on)
+//                          (settle time from WAKE_on() if the receiver is on already)
+// WAKE_idle(ms)            stay awake until no carrier for ms (end of transmission)
+// WAKE_on()                switch on receiver
+// WAKE_off()               switch off receiver
+// WAKE_carrier()           1: receiver detects carrier (output low)
+//
+// Notes:
+// ------
+// - Wake-on-IR is disabled unless WAKE_ENABLE is set to "1" in config.h.
+// - PIN_RXPWR drives the receiver directly (typ. 0.35..1.5mA), a 100nF capacitor at
+//   VS is recommended, but its charge time adds to the settle time. PIN_RXOUT must
+//   not be used by the keys.
+// - While the receiver is off, PIN_RXOUT is switched to analog input, so that no
+//   current flows through the unpowered receiver.
+// - Many receivers pull the output low for a short time after power-up while the
+//   AGC settles, WAKE_SETTLE must cover this, otherwise each window wakes the MCU.
+// - The AWU counts in steps of 1ms (periods < 64ms) to 8ms (periods < 512ms).
+// - If WAKE_HOST is defined (host builds), the pins and SysTick are replaced by the
+//   WAKE_HOST_*() functions, which have to be provided by the host program (see
+//   sim/wake_sim.c).
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <config.h>
+#include <stdint.h>
+
+// ===================================================================================
+// Wake Parameters
+// ===================================================================================
+#ifndef WAKE_ENABLE
+  #define WAKE_ENABLE     0                   // 1: include wake-on-IR functions
+#endif
+#ifndef WAKE_PERIOD
+  #define WAKE_PERIOD     64                  // AWU period in ms
+#endif
+#ifndef WAKE_SETTLE
+  #define WAKE_SETTLE     500                 // receiver power-up time in us
+#endif
+#ifndef WAKE_WINDOW
+  #define WAKE_WINDOW     1000                // time to look for carrier in us
+#endif
+#ifndef WAKE_IDLE
+  #define WAKE_IDLE       150                 // no carrier for ms: end of transmission
+#endif
+
+// ===================================================================================
+// Wake Functions
+// ===================================================================================
+void WAKE_init(void);                         // init receiver pins and AWU
+uint8_t WAKE_check(void);                     // look for IR activity, 1: found
+void WAKE_idle(uint16_t ms);                  // stay awake until no carrier for ms
+void WAKE_on(void);                           // switch on receiver
+void WAKE_off(void);                          // switch off receiver
+uint8_t WAKE_carrier(void);                   // 1: carrier detected
+
+#ifdef WAKE_HOST
+// ===================================================================================
+// Receiver Backend for Host Builds
+// ===================================================================================
+void WAKE_HOST_power(uint8_t on);             // switch receiver supply
+uint8_t WAKE_HOST_read(void);                 // receiver output, takes one poll pass
+void WAKE_HOST_delay(uint16_t us);            // busy wait
+uint32_t WAKE_HOST_now(void);                 // time in us
+extern uint16_t WAKE_HOST_settle;             // replaces WAKE_SETTLE
+extern uint16_t WAKE_HOST_window;             // replaces WAKE_WINDOW
+#endif
+
+#ifdef __cplusplus
+};
+#endif
@@ -0,0 +1,136 @@
+#!/usr/bin/env python3
+# ===================================================================================
+# Flash and SRAM Footprint Report
+# ===================================================================================
+#
+# Attributes the flash and SRAM usage of the firmware ELF to its subsystems (protocol
+# encoders, system layer, tables, vector table, ...) and prints the result as JSON,
+# so that every feature can be budgeted against the 16KB flash / 2KB SRAM limits of
+# the CH32V003.
+#
+# Symbols are assigned by their name prefix (e.g. NEC_sendCode -> "NEC"). Read-only
+# data objects that don't belong to a known prefix are counted as "tables". Whatever
+# can't be assigned to a symbol (alignment, code inlined by LTO into main, ...) shows
+# up as "unattributed".
+#
+# Usage: python3 tools/memreport.py [--nm NM] [--size SIZE] firmware.elf
+#        (usually called via 'make report')
+
+import argparse
+import json
+import subprocess
+import sys
+
+# Device limits
+FLASH_LIMIT = 16 * 1024
+SRAM_LIMIT  =  2 * 1024
+
+# Symbol name prefix -> subsystem
+PREFIXES = {
+  'NEC':    'NEC',
+  'SAM':    'SAMSUNG',
+  'SAM36':  'SAMSUNG36',
+  'SAM48':  'SAMSUNG48',
+  'RC5':    'RC5',
+  'SON':    'SIRC',
+  'LPF':    'LEGO',
+  'RMM':    'RC-MM',
+  'XMP':    'XMP',
+  'PD':     'IR',
+  'PWM':    'IR',
+  'IR':     'IR',
+  'KEY':    'KEY',
+  'WAKE':   'WAKE',
+  'DBG':    'DEBUG',
+  'FACTORY': 'FACTORY',
+  'LADDER': 'KEYPAD',
+  'TOUCH':  'KEYPAD',
+  'CLONE':  'CLONE',
+  'main':   'APP',
+  'SYS':    'SYSTEM',
+  'CLK':    'SYSTEM',
+  'MCO':    'SYSTEM',
+  'DLY':    'SYSTEM',
+  'BOOT':   'SYSTEM',
+  'IWDG':   'SYSTEM',
+  'AWU':    'SYSTEM',
+  'SLEEP':  'SYSTEM',
+  'STDBY':  'SYSTEM',
+}
+
+# Symbols of the startup code and vector table (see src/system.c)
+SYSTEM_SYMBOLS  = {'reset_handler', 'jump_reset', '__libc_init_array', '__cxa_pure_virtual'}
+VECTOR_SYMBOLS  = {'vectors', 'default_handler'}
+
+# Run a tool and return its output
+def run(cmd):
+  try:
+    return subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+  except (OSError, subprocess.CalledProcessError) as e:
+    sys.exit('ERROR: ' + ' '.join(cmd) + ': ' + str(e))
+
+# Get total flash and SRAM usage the same way 'make size' does
+def totals(size, elf):
+  for line in run([size, '-d', elf]).splitlines():
+    fields = line.split()
+    if fields and fields[0].isdigit():
+      text, data, bss = (int(x) for x in fields[:3])
+      return text + data, data + bss
+  sys.exit('ERROR: unexpected output of ' + size)
+
+# Find the subsystem a symbol belongs to
+def subsystem(name, kind):
+  if name in VECTOR_SYMBOLS or name.endswith('_Handler') or name.endswith('_IRQHandler'):
+    return 'VECTORS'
+  if name in SYSTEM_SYMBOLS:
+    return 'SYSTEM'
+  base   = name.split('.')[0]                 # strip LTO/static suffixes like ".lto_priv.0"
+  prefix = base.split('_')[0]
+  if prefix in PREFIXES:
+    return PREFIXES[prefix]
+  if kind in 'rR':
+    return 'TABLES'
+  return 'OTHER'
+
+# Attribute all sized symbols of the ELF to their subsystems
+def attribute(nm, elf):
+  result = {}
+  for line in run([nm, '-S', '-t', 'd', '--size-sort', elf]).splitlines():
+    fields = line.split()
+    if len(fields) != 4:
+      continue
+    size, kind, name = int(fields[1]), fields[2], fields[3]
+    flash = size if kind in 'TtWwRrDdGg' else 0
+    sram  = size if kind in 'DdGgBbSsVv' else 0
+    entry = result.setdefault(subsystem(name, kind), {'flash': 0, 'sram': 0, 'symbols': {}})
+    entry['flash'] += flash
+    entry['sram']  += sram
+    entry['symbols'][name] = size
+  return result
+
+def main():
+  parser = argparse.ArgumentParser(description='Flash and SRAM footprint by subsystem')
+  parser.add_argument('--nm',   default='riscv64-unknown-elf-nm',   help='nm tool')
+  parser.add_argument('--size', default='riscv64-unknown-elf-size', help='size tool')
+  parser.add_argument('elf', help='firmware ELF file')
+  args = parser.parse_args()
+
+  flash, sram = totals(args.size, args.elf)
+  parts       = attribute(args.nm, args.elf)
+  parts['UNATTRIBUTED'] = {
+    'flash': flash - sum(p['flash'] for p in parts.values()),
+    'sram':  sram  - sum(p['sram']  for p in parts.values()),
+    'symbols': {}
+  }
+
+  report = {
+    'elf':        args.elf,
+    'flash':      {'used': flash, 'limit': FLASH_LIMIT, 'free': FLASH_LIMIT - flash},
+    'sram':       {'used': sram,  'limit': SRAM_LIMIT,  'free': SRAM_LIMIT  - sram},
+    'subsystems': dict(sorted(parts.items(), key=lambda p: -p[1]['flash'])),
+  }
+  json.dump(report, sys.stdout, indent=2)
+  print()
+
+if __name__ == '__main__':
+  main()
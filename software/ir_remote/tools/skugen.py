@@ -0,0 +1,464 @@
+#!/usr/bin/env python3
+# ===================================================================================
+# SKU Configuration Compiler
+# ===================================================================================
+#
+# Reads a declarative description of a remote control variant (SKU) and writes the
+# corresponding config.h. Before anything is written, the description is checked:
+# - all pins must exist and must not be used twice, key pin numbers must be different,
+#   regardless of the port (EXTI lines are shared between ports), ladder and touch
+#   pins must be ADC inputs, the LED pins must fit the carrier generator,
+# - addresses, commands and frame lengths must be within the protocol's range,
+# - carrier frequencies and bit timings must be feasible at the chosen F_CPU,
+# - optionally, the flash/SRAM footprint of a build (see 'make report') must fit the
+#   budget.
+#
+# SKU description (INI format):
+# -----------------------------
+# [board]
+# f_cpu   = 1500000                       ; system clock, must be supported by system.h
+# led     = PA2                           ; IR LED pin
+# led2    = PA1                           ; optional second IR LED (same port as led)
+# gen     = auto                          ; carrier generator: auto, tim1 (PA2),
+#                                         ; spi (PC6) or bitbang (any pin), see src/ir.h
+# latch   = 1                             ; 1: latch key release by EXTI flag, 0: poll
+# lead    = 1                             ; 1: start header mark on key press (src/ir.h)
+# keypad  = pins                          ; pins:   KEY1..KEY5 on their own pins
+#                                         ; ladder: KEY1..KEY8 on ladder_pin (src/ladder.h)
+#                                         ; touch:  KEY1..KEY4 on touch pads (src/touch.h)
+# ladder_pin = PC4                        ; ADC input of the resistor ladder
+# wake    = 0                             ; 1: wake-on-IR (src/wake.h), receiver supply
+# rxpwr   = PC3                           ; on rxpwr, its output on rxout, wake_action
+# rxout   = PC0                           ; is called on IR activity
+# wake_action = WAKE_idle(WAKE_IDLE)
+# clone   = 0                             ; 1: cloning over IrDA SIR (src/clone.h),
+# clone_remap = 0                         ; USART1 pins 0: PD5/PD6, 1: PD0/PD1 (SWIO!),
+#                                         ; 2: PD6/PD5, 3: PC0/PC1
+# debug   = 0                             ; 1: debug output over SWIO (src/debug.h)
+# factory = 0                             ; 1: factory test mode (src/factory.h)
+#
+# [key1]
+# pin     = PC2                           ; key pin (active low), touch pad (ADC input)
+#                                         ; with keypad = touch, none with the ladder
+# send    = NEC(0x04, 0x08)               ; one or more codes, separated by semicolons
+# comment = LG TV Power
+#
+# [key2] ... [key8]                       ; pins: [key1]..[key5] must be defined,
+#                                         ; touch: [key1]..[key4] must be defined,
+#                                         ; ladder: any of [key1]..[key8], a missing key
+#                                         ; or a key without 'send' does nothing
+#
+# Supported codes: NEC(addr, cmd), SAM(addr, cmd), SAM36(addr, cmd), SAM48(addr, cmd),
+#                  RC5(addr, cmd), SON(addr, cmd, bits),
+#                  LPF(ch, mode, data), RMM(data, bits), XMP(oem, dev, sub, func)
+#
+# Usage: python3 tools/skugen.py sku.ini [-o config.h] [--report bin/ir_remote.json]
+
+import argparse
+import configparser
+import json
+import re
+import sys
+
+# System clock frequencies supported by system.h
+F_CPU_SUPPORTED = [48000000, 24000000, 16000000, 12000000, 8000000, 6000000, 4000000,
+                   3000000, 1500000, 750000, 375000, 187500, 93750]
+
+# Default system clock (F_CPU in the makefile), the delays follow F_CPU via system.h
+F_CPU_DEFAULT = 1500000
+
+# Valid pins of the CH32V003 (PA1/PA2 only on port A)
+PINS = ['PA1', 'PA2'] + ['PC%d' % i for i in range(8)] + ['PD%d' % i for i in range(8)]
+
+# Protocols: carrier frequency, shortest timing in us, argument ranges
+PROTOCOLS = {
+  'NEC': {'freq': 38000, 'tmin': 562, 'args': ('addr', 'cmd'),         'use': 'USE_NEC'},
+  'SAM': {'freq': 38000, 'tmin': 562, 'args': ('addr', 'cmd'),         'use': 'USE_SAM'},
+  'SAM36': {'freq': 38000, 'tmin': 500, 'args': ('addr', 'cmd'),       'use': 'USE_SAM'},
+  'SAM48': {'freq': 38000, 'tmin': 560, 'args': ('addr', 'cmd'),       'use': 'USE_SAM'},
+  'RC5': {'freq': 36000, 'tmin': 889, 'args': ('addr', 'cmd'),         'use': 'USE_RC5'},
+  'SON': {'freq': 40000, 'tmin': 600, 'args': ('addr', 'cmd', 'bits'), 'use': 'USE_SON'},
+  'LPF': {'freq': 38000, 'tmin': 158, 'args': ('ch', 'mode', 'data'),  'use': 'USE_LPF'},
+  'RMM': {'freq': 36000, 'tmin': 167, 'args': ('data', 'bits'),        'use': 'USE_RMM'},
+  'XMP': {'freq': 38000, 'tmin': 210, 'args': ('oem', 'dev', 'sub', 'func'), 'use': 'USE_XMP'},
+}
+
+# Maximum deviation of the generated carrier frequency (receivers have a bandpass)
+CARRIER_TOLERANCE = 0.02
+
+# Minimum number of system ticks for the shortest mark or space
+TICKS_MIN = 100
+
+# Keypads: number of keys, key pins required
+KEYPADS = {'pins': (5, True), 'ladder': (8, False), 'touch': (4, True)}
+KEYS_MAX = 8
+
+# ADC inputs (ladder and touch pads)
+ADC_PINS = ['PA1', 'PA2', 'PC4', 'PD2', 'PD3', 'PD4', 'PD5', 'PD6']
+
+# USART1 pins (TX, RX) by CLONE_REMAP and its baud rate (see src/clone.h)
+CLONE_PINS = {0: ('PD5', 'PD6'), 1: ('PD0', 'PD1'), 2: ('PD6', 'PD5'), 3: ('PC0', 'PC1')}
+CLONE_BAUD = 57600
+
+# Carrier generators (see src/ir.h) and the LED pin they require
+GENERATORS = {'auto': None, 'tim1': 'PA2', 'spi': 'PC6', 'bitbang': None}
+
+# Cycle budget of the bit-bang carrier loop (see src/ir.h)
+BB_CYC_LOOP, BB_CYC_ON, BB_CYC_OFF = 3, 1, 6
+
+class SKUError(Exception):
+  pass
+
+# Check argument ranges of a code
+def check_code(name, args):
+  if name == 'NEC':
+    addr, cmd = args
+    limits = (0xffff, 0xff)
+  elif name == 'SAM':
+    addr, cmd = args
+    limits = (0xff, 0xff)
+  elif name == 'SAM36':
+    addr, cmd = args
+    limits = (0xffff, 0xfff)
+  elif name == 'SAM48':
+    addr, cmd = args
+    limits = (0xffff, 0xffff)
+  elif name == 'RC5':
+    addr, cmd = args
+    limits = (0x1f, 0x7f)
+  elif name == 'LPF':
+    for arg, value, limit in zip(PROTOCOLS[name]['args'], args, (0x03, 0x1f, 0x0f)):
+      if not 0 <= value <= limit:
+        raise SKUError('LPF: %s 0x%x out of range (max 0x%x)' % (arg, value, limit))
+    return
+  elif name == 'RMM':
+    data, bits = args
+    if bits not in (12, 24, 32):
+      raise SKUError('RMM: frame length must be 12, 24 or 32 bits, not %d' % bits)
+    if not 0 <= data < (1 << bits):
+      raise SKUError('RMM: data 0x%x out of range for %d bits' % (data, bits))
+    return
+  elif name == 'XMP':
+    for arg, value, limit in zip(PROTOCOLS[name]['args'], args, (0xff, 0xff, 0xff, 0xffff)):
+      if not 0 <= value <= limit:
+        raise SKUError('XMP: %s 0x%x out of range (max 0x%x)' % (arg, value, limit))
+    return
+  else:
+    addr, cmd, bits = args
+    if bits not in (12, 15, 20):
+      raise SKUError('SON: frame length must be 12, 15 or 20 bits, not %d' % bits)
+    limits = ((1 << (bits - 7)) - 1, 0x7f)
+  if not 0 <= addr <= limits[0]:
+    raise SKUError('%s: address 0x%x out of range (max 0x%x)' % (name, addr, limits[0]))
+  if not 0 <= cmd <= limits[1]:
+    raise SKUError('%s: command 0x%x out of range (max 0x%x)' % (name, cmd, limits[1]))
+
+# Parse "NEC(0x04, 0x08); RC5(0, 11)" into a list of (protocol, args)
+def parse_send(text):
+  codes = []
+  for part in filter(None, (p.strip() for p in text.split(';'))):
+    m = re.fullmatch(r'(\w+)\s*\(([^)]*)\)', part)
+    if not m or m.group(1) not in PROTOCOLS:
+      raise SKUError('unknown code "%s" (supported: %s)' % (part, ', '.join(PROTOCOLS)))
+    name = m.group(1)
+    try:
+      args = tuple(int(a, 0) for a in m.group(2).split(','))
+    except ValueError:
+      raise SKUError('%s: arguments must be integers' % part)
+    if len(args) != len(PROTOCOLS[name]['args']):
+      raise SKUError('%s: expected arguments (%s)' % (part, ', '.join(PROTOCOLS[name]['args'])))
+    check_code(name, args)
+    codes.append((name, args))
+  return codes
+
+# Read a 0/1 switch of the [board] section
+def board_switch(board, name, default):
+  value = board.get(name, str(default)).strip()
+  if value not in ('0', '1'):
+    raise SKUError('[board] %s must be 0 or 1, not "%s"' % (name, value))
+  return int(value)
+
+# Check if the LED pins fit the carrier generator, returns True for bit-bang
+def check_leds(led, led2, gen):
+  if gen not in GENERATORS:
+    raise SKUError('unknown carrier generator "%s" (supported: %s)' % (gen, ', '.join(GENERATORS)))
+  for owner, pin in (('LED', led), ('LED2', led2)):
+    if pin and pin not in PINS:
+      raise SKUError('%s: pin %s does not exist on the CH32V003' % (owner, pin))
+    if pin == 'PD1':
+      raise SKUError('%s: PD1 is the SWIO programming pin' % owner)
+  if GENERATORS[gen] and led != GENERATORS[gen]:
+    raise SKUError('LED: generator %s requires the IR LED on %s' % (gen, GENERATORS[gen]))
+  if led2:
+    if gen not in ('auto', 'bitbang'):
+      raise SKUError('LED2: a second IR LED requires the bitbang generator')
+    if led2[1] != led[1] or led2 == led:
+      raise SKUError('LED2: pin %s must be a different pin on the port of %s' % (led2, led))
+  return gen == 'bitbang' or (gen == 'auto' and (led != 'PA2' or bool(led2)))
+
+# Check pins: must exist and must not be used twice, key pin numbers must be different
+# regardless of the port, ladder and touch pins must be ADC inputs
+def check_pins(leds, opts, keys):
+  owners = {}
+  def claim(owner, pin, analog=False, swio=False):
+    if pin not in PINS:
+      raise SKUError('%s: pin %s does not exist on the CH32V003' % (owner, pin))
+    if pin == 'PD1' and not swio:
+      raise SKUError('%s: PD1 is the SWIO programming pin' % owner)
+    if analog and pin not in ADC_PINS:
+      raise SKUError('%s: pin %s is not an ADC input (%s)' % (owner, pin, ', '.join(ADC_PINS)))
+    if pin in owners:
+      raise SKUError('%s: pin %s is used by %s' % (owner, pin, owners[pin]))
+    owners[pin] = owner
+
+  for owner, pin in (('LED', leds[0]), ('LED2', leds[1])):
+    if pin:
+      claim(owner, pin)
+  if opts['keypad'] == 'ladder':
+    claim('LADDER', opts['ladder_pin'], analog=True)
+  numbers = {}                                # EXTI lines of the key pins
+  for i, key in keys:
+    owner, pin = 'KEY%d' % i, key['pin']
+    if not pin:
+      continue
+    claim(owner, pin, analog=opts['keypad'] == 'touch')
+    number = int(pin[2])
+    if opts['keypad'] == 'pins' and number in numbers:
+      raise SKUError('%s: pin %s has the same pin number as %s (%s)'
+                     % (owner, pin, numbers[number][0], numbers[number][1]))
+    numbers[number] = (owner, pin)
+  if opts['wake']:
+    claim('RXPWR', opts['rxpwr'])
+    claim('RXOUT', opts['rxout'])
+  if opts['clone']:
+    tx, rx = CLONE_PINS[opts['clone_remap']]
+    claim('CLONE TX', tx)
+    claim('CLONE RX', rx, swio=True)
+
+# Check if carrier and timings can be generated at F_CPU
+def check_timing(f_cpu, protocols, bitbang):
+  if f_cpu not in F_CPU_SUPPORTED:
+    raise SKUError('F_CPU %d is not supported by system.h' % f_cpu)
+  for name in sorted(protocols):
+    p      = PROTOCOLS[name]
+    period = f_cpu // p['freq']
+    if period < 4:
+      raise SKUError('%s: carrier %d Hz needs at least 4 ticks per period at F_CPU %d'
+                     % (name, p['freq'], f_cpu))
+    error = abs(f_cpu / period - p['freq']) / p['freq']
+    if error > CARRIER_TOLERANCE:
+      raise SKUError('%s: carrier deviates %.1f%% from %d Hz at F_CPU %d'
+                     % (name, error * 100, p['freq'], f_cpu))
+    if bitbang:
+      period = (f_cpu + p['freq'] // 2) // p['freq']
+      on     = max(1, (period // 4 - BB_CYC_ON + BB_CYC_LOOP // 2) // BB_CYC_LOOP)
+      if f_cpu > 24000000 or period - BB_CYC_ON - BB_CYC_OFF - on * BB_CYC_LOOP < BB_CYC_LOOP:
+        raise SKUError('%s: carrier %d Hz exceeds the bit-bang cycle budget at F_CPU %d'
+                       % (name, p['freq'], f_cpu))
+    ticks = p['tmin'] * f_cpu // 1000000
+    if ticks < TICKS_MIN:
+      raise SKUError('%s: %dus are only %d ticks at F_CPU %d' % (name, p['tmin'], ticks, f_cpu))
+
+# Check footprint of a build against the budget
+def check_budget(report, flash_budget, sram_budget):
+  with open(report) as f:
+    data = json.load(f)
+  if data['flash']['used'] > flash_budget:
+    raise SKUError('flash: %d bytes used, budget is %d' % (data['flash']['used'], flash_budget))
+  if data['sram']['used'] > sram_budget:
+    raise SKUError('SRAM: %d bytes used, budget is %d' % (data['sram']['used'], sram_budget))
+  return data['flash']['used'], data['sram']['used']
+
+# Convert a code into the C function call of main.c
+def c_call(name, args):
+  if name == 'SON':
+    return 'SON_sendCode(0x%02X,0x%02X,%d)' % args
+  if name == 'LPF':
+    return 'LPF_sendCode(%d,0x%02X,0x%X)' % args
+  if name in ('SAM36', 'SAM48'):
+    return '%s_sendCode(0x%04X,0x%04X)' % ((name,) + args)
+  if name == 'RMM':
+    return 'RMM_sendCode(0x%X,%d)' % args
+  if name == 'XMP':
+    return 'XMP_sendCode(0x%02X,0x%02X,0x%02X,0x%04X)' % args
+  return '%s_sendCode(0x%02X,0x%02X)' % ((name,) + args)
+
+# Check options that depend on each other
+def check_options(f_cpu, opts):
+  if opts['clone'] and f_cpu < 16 * CLONE_BAUD:
+    raise SKUError('clone: %d baud need at least F_CPU %d (16x oversampling)'
+                   % (CLONE_BAUD, 16 * CLONE_BAUD))
+  if opts['clone'] and opts['clone_remap'] == 1 and opts['debug']:
+    raise SKUError('clone: clone_remap 1 uses PD1 (SWIO), which the debug output needs')
+  if opts['factory'] and opts['keypad'] == 'touch':
+    raise SKUError('factory: the test mode can\'t be entered by touch pads')
+
+# Create config.h
+def generate(sku, f_cpu, led, led2, gen, keys, protocols, opts):
+  lines = [
+    '// ' + '=' * 83,
+    '// User Configurations (generated by tools/skugen.py from %s, do not edit)' % sku,
+    '// ' + '=' * 83,
+    '',
+    '#pragma once',
+    '',
+    '// Assign IR commands to the keys (multiple commands must be separated by semicolons!)',
+  ]
+  defined = dict(keys)
+  for i in range(1, KEYS_MAX + 1):
+    key = defined.get(i, {'codes': [], 'comment': ''})
+    calls = '; '.join(c_call(*c) for c in key['codes']) or 'DLY_ms(10)'
+    comment = key['comment'] or ('' if key['codes'] else 'nothing')
+    lines.append(('#define KEY%d  %-28s// %s' % (i, calls, comment)).rstrip(' /'))
+  lines += ['', '// Protocols to include (set "0" to exclude a protocol you don\'t use from the firmware)']
+  uses = {}                                   # variants share the switch of their family
+  for name in PROTOCOLS:
+    use = PROTOCOLS[name]['use']
+    uses[use] = uses.get(use, 0) | (name in protocols)
+  for use, on in uses.items():
+    lines.append('#define %-11s %d' % (use, 1 if on else 0))
+  keypad = opts['keypad']
+  if keypad == 'pins':
+    lines += ['', '// Pin definitions for keys (pin numbers must be different, regardless of the port!)']
+    for i, key in keys:
+      lines.append('#define PIN_KEY%d    %-22s// define pin to KEY%d (active low)'
+                   % (i, key['pin'], i))
+  else:                                       # unused, but checked by wake.c and clone.c
+    lines += ['', '// Pin definitions for keys (not used, set to the %s pins for the pin checks)'
+              % keypad]
+    for i in range(1, KEYPADS['pins'][0] + 1):
+      alias = 'PIN_LADDER' if keypad == 'ladder' else 'PIN_TOUCH%d' % min(i, KEYPADS['touch'][0])
+      lines.append('#define PIN_KEY%d    %s' % (i, alias))
+  lines.append('#define KEY_LATCH   %-22d// 1: latch key release by EXTI flag, 0: poll pins'
+               % opts['latch'])
+  lines.append('#define KEY_LEAD    %-22d// 1: start header mark on key press, debounce meanwhile'
+               % opts['lead'])
+  lines += ['', '// Resistor-ladder keypad with KEY1..KEY8 on a single ADC pin instead (see src/ladder.h)',
+            '#define LADDER_ENABLE %-20d// 1: read keys from PIN_LADDER by the ADC'
+            % (keypad == 'ladder')]
+  if keypad == 'ladder':
+    lines.append('#define PIN_LADDER  %-22s// define pin to ladder (ADC input, ext. pullup)'
+                 % opts['ladder_pin'])
+  lines += ['', '// Capacitive touch keys with KEY1..KEY4 on touch pads instead (see src/touch.h)',
+            '#define TOUCH_ENABLE %-21d// 1: read keys from touch pads, scan by AWU'
+            % (keypad == 'touch')]
+  if keypad == 'touch':
+    for i, key in keys:
+      lines.append('#define PIN_TOUCH%d  %-22s// define pin to touch pad %d (ADC input, ext. pullup)'
+                   % (i, key['pin'], i))
+  lines += ['', '// Pin definition for IR-LED and carrier generator (see src/ir.h)',
+            '#define PIN_LED     %s' % led]
+  if led2:
+    lines.append('#define PIN_LED2    %s' % led2)
+  lines += ['#define IR_GEN      IR_GEN_%s' % gen.upper()]
+  lines += ['', '// Wake-on-IR with a duty-cycled IR receiver (see src/wake.h)',
+            '#define WAKE_ENABLE %-22d// 1: look for IR activity every WAKE_PERIOD ms'
+            % opts['wake']]
+  if opts['wake']:
+    lines += ['#define PIN_RXPWR   %-22s// define pin to supply (VS) of IR receiver' % opts['rxpwr'],
+              '#define PIN_RXOUT   %-22s// define pin to output of IR receiver (active low)'
+              % opts['rxout'],
+              '#define WAKE_ACTION %-22s// action on IR activity' % opts['wake_action']]
+  lines += ['', '// Remote-to-remote cloning over IrDA SIR on USART1 (see src/clone.h)',
+            '#define CLONE_ENABLE %-21d// 1: include CLONE_*() functions for key actions'
+            % opts['clone']]
+  if opts['clone']:
+    tx, rx = CLONE_PINS[opts['clone_remap']]
+    lines.append('#define CLONE_REMAP %-22d// USART1 TX on %s, RX on %s%s'
+                 % (opts['clone_remap'], tx, rx, ' (SWIO, no programmer!)' if rx == 'PD1' else ''))
+  lines += ['', '// Debug output over SWIO, read by the programmer (see src/debug.h)',
+            '#define DBG_ENABLE  %-22d// 1: write debug messages into the mailbox' % opts['debug'],
+            '', '// Factory test mode: test sequence for an IR test fixture (see src/factory.h)',
+            '#define FACTORY_ENABLE %-19d// 1: send test sequence on a key combination at power-up'
+            % opts['factory'], '']
+  return '\n'.join(lines)
+
+def main():
+  parser = argparse.ArgumentParser(description='Compile a SKU description into config.h')
+  parser.add_argument('sku', help='SKU description (INI)')
+  parser.add_argument('-o', '--output', help='config.h to write (default: stdout)')
+  parser.add_argument('--report', help='footprint report of a build (make report)')
+  parser.add_argument('--flash-budget', type=int, default=16384, help='flash budget in bytes')
+  parser.add_argument('--sram-budget',  type=int, default=2048,  help='SRAM budget in bytes')
+  args = parser.parse_args()
+
+  ini = configparser.ConfigParser(inline_comment_prefixes=(';', '#'))
+  try:
+    if not ini.read(args.sku):
+      raise SKUError('cannot read %s' % args.sku)
+    unknown = [s for s in ini.sections()
+               if s != 'board' and not re.fullmatch(r'key[1-%d]' % KEYS_MAX, s)]
+    if unknown:
+      raise SKUError('unsupported section(s) %s (this firmware has up to %d keys and no '
+                     'layers or gestures)' % (', '.join(unknown), KEYS_MAX))
+    board = ini['board'] if ini.has_section('board') else {}
+    f_cpu = int(board.get('f_cpu', str(F_CPU_DEFAULT)), 0)
+    led   = board.get('led', 'PA2').upper()
+    led2  = board.get('led2', '').upper()
+    gen   = board.get('gen', 'auto').lower()
+    opts  = {
+      'latch':       board_switch(board, 'latch', 1),
+      'lead':        board_switch(board, 'lead', 1),
+      'keypad':      board.get('keypad', 'pins').lower(),
+      'ladder_pin':  board.get('ladder_pin', 'PC4').upper(),
+      'wake':        board_switch(board, 'wake', 0),
+      'rxpwr':       board.get('rxpwr', 'PC3').upper(),
+      'rxout':       board.get('rxout', 'PC0').upper(),
+      'wake_action': board.get('wake_action', 'WAKE_idle(WAKE_IDLE)'),
+      'clone':       board_switch(board, 'clone', 0),
+      'clone_remap': int(board.get('clone_remap', '0'), 0),
+      'debug':       board_switch(board, 'debug', 0),
+      'factory':     board_switch(board, 'factory', 0),
+    }
+    if opts['keypad'] not in KEYPADS:
+      raise SKUError('unknown keypad "%s" (supported: %s)' % (opts['keypad'], ', '.join(KEYPADS)))
+    if opts['clone_remap'] not in CLONE_PINS:
+      raise SKUError('[board] clone_remap must be 0..3, not %d' % opts['clone_remap'])
+    count, pins = KEYPADS[opts['keypad']]
+
+    keys = []
+    for i in range(1, KEYS_MAX + 1):
+      section = 'key%d' % i
+      if not ini.has_section(section):
+        if pins and i <= count:
+          raise SKUError('[%s] with a pin is required' % section)
+        continue
+      if i > count:
+        raise SKUError('[%s] is not available with keypad = %s (%d keys)'
+                       % (section, opts['keypad'], count))
+      if pins != ('pin' in ini[section]):
+        raise SKUError('[%s] %s' % (section, 'a pin is required' if pins else
+                                    'keys on the ladder have no pin'))
+      try:
+        codes = parse_send(ini[section].get('send', ''))
+      except SKUError as e:
+        raise SKUError('[%s] %s' % (section, e))
+      keys.append((i, {'pin': ini[section].get('pin', '').upper(), 'codes': codes,
+                       'comment': ini[section].get('comment', '')}))
+
+    protocols = {name for _, key in keys for name, _ in key['codes']}
+    bitbang  = check_leds(led, led2, gen)
+    check_pins((led, led2), opts, keys)
+    check_options(f_cpu, opts)
+    check_timing(f_cpu, protocols, bitbang)
+    if args.report:
+      flash, sram = check_budget(args.report, args.flash_budget, args.sram_budget)
+      print('Footprint: %d/%d bytes flash, %d/%d bytes SRAM'
+            % (flash, args.flash_budget, sram, args.sram_budget), file=sys.stderr)
+  except (SKUError, ValueError, configparser.Error) as e:
+    sys.exit('%s: ERROR: %s' % (args.sku, e))
+
+  config = generate(args.sku, f_cpu, led, led2, gen, keys, protocols, opts)
+  if opts['clone'] and opts['clone_remap'] == 1:
+    print('%s: NOTE: the transceiver on PD1 blocks the programmer (SWIO)' % args.sku,
+          file=sys.stderr)
+  if f_cpu != F_CPU_DEFAULT:
+    print('%s: NOTE: pass F_CPU=%d to make' % (args.sku, f_cpu), file=sys.stderr)
+  if args.output:
+    with open(args.output, 'w') as f:
+      f.write(config)
+  else:
+    sys.stdout.write(config)
+
+if __name__ == '__main__':
+  main()